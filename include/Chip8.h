@@ -1,12 +1,29 @@
 #pragma once
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
 #include "constants.h"
+#include "Chip8_Frame.h"
+#include "Chip8_Hash.h"
+#include "Chip8_Machine.h"
+#include "Chip8_Memory.h"
+#include "Chip8_Platform.h"
+#include "Chip8_Quirks.h"
+#include "Chip8_Timeline.h"
+#include "Chip8_Timing.h"
+#include "Chip8_Trace.h"
 
 
-class Chip8 {
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+class Chip8_Core final : public Chip8_Machine {
     private:
+        static constexpr int FRAME_WORDS = Platform::FRAME_WIDTH / 64;
+        static constexpr int PLANE_WORDS = Platform::FRAME_HEIGHT * FRAME_WORDS;
+
         unsigned char stack[STACK_BYTES];
-        unsigned char main_memory[MEMORY_BYTES];
+        // shared with forks until either side writes to a page
+        Paged_Memory<Platform::MEMORY_BYTES> main_memory;
         unsigned char registers[16];
         unsigned char sound_timer;
         unsigned char delay_timer;
@@ -15,27 +32,155 @@ class Chip8 {
         unsigned short index_register;
 
         unsigned char key_register = -1;
+        // bit i is set while key i of the hex keypad is held down
+        unsigned short keypad = 0;
 
-    public:
-        bool frame_buffer[PIXELS_WIDTH * PIXELS_HEIGHT];
-        bool draw_flag = 1;
+        uint64_t frame_buffer[Platform::PLANES * PLANE_WORDS];
+        uint64_t frame_hash = 0;
+        // SUPER-CHIP state
+        bool hires = false;
+        bool halted = false;
+        Chip8_Fault fault = Chip8_Fault::NONE;
+        unsigned char rpl_flags[RPL_FLAGS] = {0};
+        // XO-CHIP state
+        unsigned char plane_mask = 1;
+        unsigned char audio_pattern[AUDIO_PATTERN_BYTES] = {0};
+        bool has_audio_pattern = false;
+        unsigned char pitch = DEFAULT_AUDIO_PITCH;
+
+        uint32_t random_state = RANDOM_SEED;
+
+        // virtual time: instructions cost Timing::cycles and the timers tick
+        // once every cycles_per_tick cycles, whatever the host is doing
+        unsigned long long cycles = 0;
+        unsigned int cycles_per_tick = Timing::CYCLES_PER_TICK;
+        unsigned long long next_tick = Timing::CYCLES_PER_TICK;
+
+        unsigned long long keys_seen[16] = {0};
+        unsigned long long sprites_drawn = 0;
+        unsigned long long idle_cycles = 0;
+        unsigned long long invalid_instructions = 0;
+
+        Trace_Policy trace;
 
     public:
-        Chip8();
-        void load_rom_to_memory(std::string);
-        void update_timers();
-        void complete_one_instruction();
+        Chip8_Core();
+        bool load_rom_to_memory(std::string) override;
+        void load_rom(const unsigned char* bytes, size_t size) override;
+        void patch_rom(const unsigned char* bytes, size_t size) override;
+        void complete_one_instruction() override;
+        void run_instructions(unsigned int count) override;
+        void run_frame() override;
+
+        // keeps the tick phase: the next tick moves by the change, so
+        // setting the same value again, as a replay does, changes nothing
+        inline void set_cycles_per_tick(unsigned int cycles_per_tick) override {
+            if (cycles_per_tick == 0) {
+                return;
+            }
+            next_tick = next_tick - this->cycles_per_tick + cycles_per_tick;
+            this->cycles_per_tick = cycles_per_tick;
+            // a shorter tick can leave the next one behind; take it next
+            if (next_tick <= cycles) {
+                next_tick = cycles + 1;
+            }
+        }
+        inline unsigned int get_cycles_per_tick() override { return cycles_per_tick; }
+        inline unsigned long long get_cycles() override { return cycles; }
+
+        inline void set_keypad(unsigned short keys) override { keypad = keys; }
+        inline unsigned short get_keypad() override { return keypad; }
 
-        inline bool* get_frame_buffer() { return frame_buffer; }
+        inline bool is_sound_on() override { return sound_timer > 0; }
+        // the XO-CHIP audio pattern, or nullptr to play the plain buzzer
+        inline const unsigned char* get_audio_pattern() override { return has_audio_pattern ? audio_pattern : nullptr; }
+        inline unsigned char get_pitch() override { return pitch; }
+        // set by the SUPER-CHIP exit instruction 00FD
+        inline bool is_halted() override { return halted; }
+        inline Chip8_Fault get_fault() override { return fault; }
+        inline Chip8_Counters get_counters() override {
+            Chip8_Counters counters = {{0}, sprites_drawn, cycles, idle_cycles, invalid_instructions};
+            memcpy(counters.keys_seen, keys_seen, sizeof(keys_seen));
+            return counters;
+        }
+
+        inline Frame_View get_frame_view() const override {
+            return {frame_buffer, Platform::FRAME_WIDTH, Platform::FRAME_HEIGHT, FRAME_WORDS, Platform::PLANES};
+        }
+        inline Trace_Policy& get_trace() override { return trace; }
+
+        Chip8_Cpu_State get_cpu_state() const override;
+        inline unsigned char read_memory(unsigned short address) const override { return main_memory[address]; }
+        uint64_t hash_state() const override;
+        inline uint64_t get_frame_hash() const override { return frame_hash; }
+
+        inline std::unique_ptr<Chip8_Machine> fork() const override { return std::make_unique<Chip8_Core>(*this); }
+        inline void copy_state_from(const Chip8_Machine& other) override { *this = static_cast<const Chip8_Core&>(other); }
+        inline void restore_state_from(const Chip8_Machine& other) override {
+            const Chip8_Core& source = static_cast<const Chip8_Core&>(other);
+            // hold on to our own pages while everything else is copied, then
+            // fill them with the source's memory
+            Paged_Memory<Platform::MEMORY_BYTES> own_pages = main_memory;
+            *this = source;
+            own_pages.copy_bytes_from(source.main_memory);
+            main_memory = own_pages;
+        }
 
     private:
         void initialize_main_memory();
+        void update_timers();
         void clear_frame_buffer();
 
         unsigned short pop_stack();
         void push_stack(unsigned short);
+        void invalid_instruction(unsigned short instruction);
+        // halts the machine for good
+        void stop(Chip8_Fault reason);
+
+        // xorshift32
+        inline unsigned char next_random() {
+            random_state ^= random_state << 13;
+            random_state ^= random_state >> 17;
+            random_state ^= random_state << 5;
+            return (unsigned char)(random_state >> 24);
+        }
 
         bool wait_for_key();
+        inline bool is_key_pressed(unsigned char key) { return (keypad >> (key & 0xFu)) & 1u; }
+
+        unsigned int execute_next_instruction();
+        void execute(unsigned short);
 
-        void detail_instruction(std::string);
+        // XO-CHIP skips over the whole 4 byte F000 NNNN instruction
+        inline void skip_instruction() {
+            if (Platform::XO_CHIP && main_memory[program_counter] == 0xF0u && main_memory[program_counter + 1] == 0x00u) {
+                program_counter += 2;
+            }
+            program_counter += 2;
+        }
+        // XO-CHIP scrolls by low resolution pixels in low resolution mode
+        inline int scroll_scale() { return Platform::XO_CHIP && !hires ? Platform::LORES_SCALE : 1; }
+
+        void draw_sprite(unsigned char x, unsigned char y, unsigned short rows);
+        bool xor_row(uint64_t* row, uint64_t bits, int x);
+        inline void xor_frame_word(uint64_t* word, uint64_t bits) {
+            if (bits != 0) {
+                uint64_t index = word - frame_buffer;
+                frame_hash ^= element_hash(index, *word) ^ element_hash(index, *word ^ bits);
+                *word ^= bits;
+            }
+        }
+        // for the operations that move or clear many words anyway
+        void rehash_frame();
+        void clear_selected_planes();
+        void set_resolution(bool);
+        void scroll_down(int rows);
+        void scroll_up(int rows);
+        void scroll_right(int pixels);
+        void scroll_left(int pixels);
 };
+
+// Each platform with the quirks it is usually run with
+using Chip8 = Chip8_Core<Chip8_Platform, Modern_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+using Super_Chip8 = Chip8_Core<Super_Chip_Platform, Super_Chip_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+using Xo_Chip8 = Chip8_Core<Xo_Chip_Platform, Xo_Chip_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <cstring>
+#include "constants.h"
+
+// Single producer, single consumer ring of samples. The emulator pushes and
+// the audio device pulls; neither side takes a lock or allocates, so the
+// audio callback can never block on the emulation thread.
+class Sample_Ring {
+    public:
+        static constexpr unsigned int CAPACITY = 1u << 12;
+
+    private:
+        short samples[CAPACITY];
+        // head and tail only ever grow; the index is taken modulo CAPACITY
+        alignas(64) std::atomic<unsigned int> head{0};
+        alignas(64) std::atomic<unsigned int> tail{0};
+
+    public:
+        inline unsigned int size() const {
+            return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+        }
+
+        // producer side, returns how many samples fit
+        inline unsigned int push(const short* in, unsigned int count) {
+            unsigned int h = head.load(std::memory_order_relaxed);
+            unsigned int free = CAPACITY - (h - tail.load(std::memory_order_acquire));
+            count = count < free ? count : free;
+            unsigned int start = h & (CAPACITY - 1);
+            unsigned int first = CAPACITY - start < count ? CAPACITY - start : count;
+            memcpy(samples + start, in, first * sizeof(short));
+            memcpy(samples, in + first, (count - first) * sizeof(short));
+            head.store(h + count, std::memory_order_release);
+            return count;
+        }
+
+        // consumer side, returns how many samples were available
+        inline unsigned int pop(short* out, unsigned int count) {
+            unsigned int t = tail.load(std::memory_order_relaxed);
+            unsigned int available = head.load(std::memory_order_acquire) - t;
+            count = count < available ? count : available;
+            unsigned int start = t & (CAPACITY - 1);
+            unsigned int first = CAPACITY - start < count ? CAPACITY - start : count;
+            memcpy(out, samples + start, first * sizeof(short));
+            memcpy(out + first, samples, (count - first) * sizeof(short));
+            tail.store(t + count, std::memory_order_release);
+            return count;
+        }
+};
+
+// Turns the sound timer into samples. The plain buzzer is a BUZZER_HZ square
+// wave; once an XO-CHIP ROM loads a pattern the 128 pattern bits are played
+// at the pitch register's rate instead. The phase is kept across calls and
+// across pitch changes, so the waveform never jumps.
+class Beeper {
+    private:
+        Sample_Ring ring;
+        unsigned int sample_rate;
+        // most samples the emulator keeps queued, and how many the device
+        // takes at a time
+        unsigned int buffered_samples;
+        unsigned int chunk_samples;
+
+        // fraction of the current period in 1/2^32ths
+        unsigned int phase = 0;
+        unsigned int buzzer_step;
+        unsigned char pattern_pitch = DEFAULT_AUDIO_PITCH;
+        unsigned int pattern_step;
+
+    public:
+        Beeper(unsigned int sample_rate = AUDIO_SAMPLE_RATE, unsigned int buffered_samples = AUDIO_BUFFERED_SAMPLES,
+               unsigned int chunk_samples = AUDIO_CHUNK_SAMPLES);
+
+        inline unsigned int get_sample_rate() const { return sample_rate; }
+        inline unsigned int get_buffered_samples() const { return buffered_samples; }
+        inline unsigned int get_chunk_samples() const { return chunk_samples; }
+        inline unsigned int get_queued() const { return ring.size(); }
+
+        // emulator side: tops the ring up to buffered_samples using
+        // the current state of the machine
+        void fill(bool sound_on, const unsigned char* pattern, unsigned char pitch);
+
+        // emulator side: queues exactly count samples, as far as they fit
+        void queue(unsigned int count, bool sound_on, const unsigned char* pattern, unsigned char pitch);
+
+        // audio device side: always writes count samples, padding with
+        // silence if the emulator fell behind
+        void read(short* out, unsigned int count);
+
+    private:
+        unsigned int step_for(double hz) const;
+        void generate(short* out, unsigned int count, bool sound_on, const unsigned char* pattern, unsigned char pitch);
+};
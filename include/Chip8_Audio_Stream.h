@@ -0,0 +1,33 @@
+#pragma once
+#include "Chip8_Audio.h"
+#include <SFML/Audio/SoundStream.hpp>
+
+// Plays a Beeper through SFML. onGetData runs on SFML's audio thread and only
+// copies out of the beeper's lock-free ring into a preallocated chunk.
+//
+// SFML 2.6 lets the stream refill every AUDIO_REFILL_MS. Older versions wait
+// 10 ms between refills, so they take larger chunks and a deeper queue to
+// play through the gaps, and trail the sound timer by 3 * 256 + 512 = 1280
+// samples, 29 ms.
+class Chip8_Audio_Stream : public sf::SoundStream {
+    public:
+#if SFML_VERSION_MAJOR > 2 || (SFML_VERSION_MAJOR == 2 && SFML_VERSION_MINOR >= 6)
+        static constexpr unsigned int CHUNK_SAMPLES = AUDIO_CHUNK_SAMPLES;
+        static constexpr unsigned int BUFFERED_SAMPLES = AUDIO_BUFFERED_SAMPLES;
+#else
+        static constexpr unsigned int CHUNK_SAMPLES = 256;
+        static constexpr unsigned int BUFFERED_SAMPLES = 512;
+#endif
+
+    private:
+        Beeper& beeper;
+        sf::Int16 chunk[CHUNK_SAMPLES];
+
+    public:
+        Chip8_Audio_Stream(Beeper& beeper);
+        ~Chip8_Audio_Stream();
+
+    protected:
+        bool onGetData(Chunk& data) override;
+        void onSeek(sf::Time) override;
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include "Chip8_Audio.h"
+#include "Chip8_Frame.h"
+
+// Everything the emulator needs from the outside world. The core never talks
+// to a window, keyboard or sound device directly, so it builds and runs
+// without a windowing stack; frontends implement this interface instead.
+class Chip8_Backend {
+    public:
+        virtual ~Chip8_Backend() {}
+
+        // false once the frontend wants the emulator to stop
+        virtual bool is_open() = 0;
+
+        // display, showing the frame the backend was constructed with
+        virtual void render() = 0;
+
+        // input, returned as a keypad bitmask where bit i is key i
+        virtual unsigned short poll_input() = 0;
+
+        // audio, called whenever the state of the sound timer changes
+        virtual void set_sound(bool on) = 0;
+
+        // audio, the beeper the frontend plays from, or nullptr if it has no
+        // sound device; the emulator keeps it filled
+        virtual Beeper* get_beeper() { return nullptr; }
+};
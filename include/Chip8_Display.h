@@ -1,11 +1,34 @@
-#include "Chip8.h"
+#include "Chip8_Audio_Stream.h"
+#include "Chip8_Frame.h"
+#include "Chip8_Backend.h"
+#include <map>
 #include <SFML/Config.hpp>
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/Graphics/Texture.hpp>
+#include <SFML/Window/Keyboard.hpp>
 
-class Chip8_Display {
+const std::map<unsigned char, sf::Keyboard::Key> CHIP_8_KEYS = {
+    {0x00, sf::Keyboard::X},
+    {0x01, sf::Keyboard::Num1},
+    {0x02, sf::Keyboard::Num2},
+    {0x03, sf::Keyboard::Num3},
+    {0x04, sf::Keyboard::Q},
+    {0x05, sf::Keyboard::W},
+    {0x06, sf::Keyboard::E},
+    {0x07, sf::Keyboard::A},
+    {0x08, sf::Keyboard::S},
+    {0x09, sf::Keyboard::D},
+    {0x0A, sf::Keyboard::Z},
+    {0x0B, sf::Keyboard::C},
+    {0x0C, sf::Keyboard::Num4},
+    {0x0D, sf::Keyboard::R},
+    {0x0E, sf::Keyboard::F},
+    {0x0F, sf::Keyboard::V},
+};
+
+class Chip8_Display : public Chip8_Backend {
     private:
-        Chip8 chip8;
+        Frame_View frame;
         sf::RenderWindow* window;
         int pixel_box_size;
 
@@ -15,11 +38,21 @@ class Chip8_Display {
         sf::Texture* texture;
         sf::Uint8* pixels;
 
+        unsigned short keypad = 0;
+
+        Beeper beeper;
+        Chip8_Audio_Stream* audio_stream;
+
     public:
-        Chip8_Display(Chip8, int);
-        void render(bool[]);
+        Chip8_Display(Frame_View, int);
         ~Chip8_Display();
 
+        bool is_open() override;
+        void render() override;
+        unsigned short poll_input() override;
+        void set_sound(bool) override;
+        inline Beeper* get_beeper() override { return &beeper; }
+
         inline sf::RenderWindow* get_window() { return window; }
 
     private:
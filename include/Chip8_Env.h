@@ -0,0 +1,73 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// C interface to a batch of machines running the same ROM, stepped together
+// as a reinforcement learning environment. Built as the shared library
+// libchip8_env; python/chip8_env.py wraps it with ctypes.
+//
+// Every step holds each machine's action (a keypad bitmask, bit i is key i)
+// down for n_frames frames, then writes the batch's observations, rewards
+// and done flags into caller-owned arrays, machine after machine. Stepping
+// allocates nothing, resets included: each machine is given memory of its
+// own when it is created and resets copy the starting state into it. A
+// machine that finishes its episode is reset at once, so its observation is
+// the first one of the next episode.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// reward += scale * (new value - old value) for a size byte (1 or 2, big
+// endian) number at address in the machine's memory, e.g. a score
+typedef struct {
+    uint16_t address;
+    uint8_t size;
+    float scale;
+} chip8_env_reward;
+
+typedef struct {
+    // names as on the command line; NULL picks chip8 and its usual quirks
+    const char* variant;
+    const char* quirks;
+    // 0 uses DEFAULT_INSTRUCTIONS_PER_FRAME
+    unsigned int instructions_per_frame;
+    // observations hold the frame buffer as Frame_View packs it (planes *
+    // height * words_per_row 64 bit words) rather than a byte per pixel
+    // holding its colour index
+    int bit_packed;
+    // observations combine the last two frames of each step, a pixel lit in
+    // either being lit, so sprites drawn on alternate frames are not lost
+    int max_pool;
+    const chip8_env_reward* rewards;
+    unsigned int reward_count;
+    // episodes end when the machine halts, when the byte at done_address
+    // equals done_value (done_address -1 disables this) or after max_frames
+    // frames (0 for no limit)
+    int done_address;
+    uint8_t done_value;
+    unsigned long long max_frames;
+} chip8_env_config;
+
+typedef struct chip8_env chip8_env;
+
+// NULL if the config names an unknown variant or quirk set, a reward's size
+// is not 1 or 2 or batch is 0
+chip8_env* chip8_env_create(const unsigned char* rom, size_t rom_size, unsigned int batch,
+                            const chip8_env_config* config);
+void chip8_env_destroy(chip8_env* env);
+
+unsigned int chip8_env_batch(const chip8_env* env);
+// bytes of one machine's observation; the batch's are back to back
+size_t chip8_env_observation_size(const chip8_env* env);
+void chip8_env_frame_size(const chip8_env* env, int* width, int* height);
+
+// starts a new episode on every machine
+void chip8_env_reset(chip8_env* env, uint8_t* observations);
+// actions, rewards and dones hold one entry per machine
+void chip8_env_step(chip8_env* env, const uint16_t* actions, unsigned int n_frames, uint8_t* observations,
+                    float* rewards, uint8_t* dones);
+
+#ifdef __cplusplus
+}
+#endif
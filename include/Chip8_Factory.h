@@ -0,0 +1,22 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "Chip8_Machine.h"
+
+// Builds the Chip8_Core specialization for a platform, quirk set and timing
+// model
+std::unique_ptr<Chip8_Machine> make_chip8(Chip8_Variant variant, Chip8_Quirk_Set quirks,
+                                          Chip8_Timing_Model timing = Chip8_Timing_Model::INSTRUCTIONS);
+
+// The quirks a platform's games are usually written for
+Chip8_Quirk_Set default_quirks(Chip8_Variant variant);
+
+// Guesses the platform of a ROM from its extension (.ch8, .sc8, .xo8) and,
+// failing that, from instructions only SUPER-CHIP or XO-CHIP have
+Chip8_Variant detect_variant(const std::string& rom_file_name);
+
+// Names used on the command line: chip8, schip, xochip; modern, cowgod, vip,
+// schip, xochip; and instructions, vip. Return false for unknown names.
+bool parse_variant(const char* name, Chip8_Variant& variant);
+bool parse_quirk_set(const char* name, Chip8_Quirk_Set& quirks);
+bool parse_timing_model(const char* name, Chip8_Timing_Model& timing);
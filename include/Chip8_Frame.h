@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+// Non-owning view of a core's live frame buffer. Displays and encoders keep
+// one of these instead of copying the machine, so they always see the
+// current frame and any number of them can observe the same core.
+//
+// Rows are packed 64 pixels per word with the leftmost pixel in the most
+// significant bit, the same order sprites use. Each plane is a full frame;
+// a pixel's colour index has bit p set when it is lit in plane p.
+struct Frame_View {
+    const uint64_t* rows;
+    int width;
+    int height;
+    int words_per_row;
+    int planes;
+
+    inline unsigned char at(int x, int y) const {
+        unsigned char colour = 0;
+        for (int p = 0; p < planes; p++) {
+            const uint64_t* plane = rows + p * height * words_per_row;
+            colour |= ((plane[y * words_per_row + x / 64] >> (63 - x % 64)) & 1u) << p;
+        }
+        return colour;
+    }
+};
+
+// Receives every emulated frame at the timer rate (TIMER_HZ), e.g. to record
+// video. Implementations must return quickly; they run on the emulation thread.
+class Frame_Sink {
+    public:
+        virtual ~Frame_Sink() {}
+        virtual void submit_frame(const Frame_View& frame) = 0;
+};
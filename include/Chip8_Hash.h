@@ -0,0 +1,47 @@
+#pragma once
+#include <cctype>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+// 64 bit FNV-1a. Hashing a buffer in pieces gives the same result as hashing
+// it in one go, so states can be hashed field by field.
+const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+const uint64_t FNV_PRIME = 0x100000001b3ull;
+
+inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// splitmix64's finalizer
+inline uint64_t mix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// A buffer's running hash is the XOR of element_hash over its elements, so
+// changing one element from old to value updates it in O(1) with
+//   hash ^= element_hash(position, old) ^ element_hash(position, value)
+// Zero elements add nothing, so an all-zero buffer hashes to 0.
+inline uint64_t element_hash(uint64_t position, uint64_t value) {
+    return value == 0 ? 0 : mix64(mix64(position) + value);
+}
+
+// Reads a hash written in hex, as the profiles and test manifests hold them.
+// False unless the whole of text is one 64 bit hex number.
+inline bool parse_hash(const char* text, uint64_t& hash) {
+    if (!isxdigit((unsigned char)text[0])) {
+        return false;
+    }
+    char* end;
+    errno = 0;
+    hash = strtoull(text, &end, 16);
+    return *end == '\0' && errno == 0;
+}
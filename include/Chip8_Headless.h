@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdio>
+#include "Chip8_Backend.h"
+
+// Backend without a window, keyboard or sound device. It keeps the last
+// rendered frame so callers can inspect it. Passed to the runner as a sink
+// too, it closes itself once max_frames frames have been emulated (0 runs
+// forever).
+class Chip8_Headless : public Chip8_Backend, public Frame_Sink {
+    private:
+        Frame_View frame;
+        unsigned long long frames = 0;
+        unsigned long long max_frames;
+
+    public:
+        Chip8_Headless(Frame_View frame, unsigned long long max_frames = 0);
+
+        bool is_open() override;
+        void render() override;
+        unsigned short poll_input() override;
+        void set_sound(bool) override;
+        void submit_frame(const Frame_View&) override;
+
+        inline unsigned long long get_frames() { return frames; }
+        void print_frame(FILE*);
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include "constants.h"
+#include "Chip8_Machine.h"
+
+// Millisecond histogram: bucket i holds samples in [i, i + 1) ms and the
+// last bucket everything slower
+class Latency_Histogram {
+    private:
+        unsigned long long buckets[LATENCY_BUCKETS] = {0};
+        unsigned long long count = 0;
+        double total_ms = 0;
+        double max_ms = 0;
+
+    public:
+        void add(double ms);
+        // upper edge of the bucket holding the p-th percentile
+        double percentile(double p) const;
+        void print(FILE* out, const char* name) const;
+};
+
+// Follows one key press at a time from the moment the frontend reports it,
+// to the first instruction that reads that key, to the first sprite drawn
+// after that, to the frame holding that sprite reaching the screen. A press
+// that the game never reacts to is given up after a second.
+//
+// The machine is only looked at between frames, so the first two stages are
+// timed at the end of the frame they happen in and can be up to a frame
+// late. The sprite is whichever one comes first after the read, which need
+// not be the game's answer to the key.
+class Latency_Monitor {
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        enum class Stage {
+            IDLE,
+            ARRIVED,
+            SEEN,
+            DRAWN,
+        };
+        Stage stage = Stage::IDLE;
+        Clock::time_point arrived;
+        // bitmask of the keys that went down
+        unsigned short pressed = 0;
+
+        Latency_Histogram to_seen;
+        Latency_Histogram to_drawn;
+        Latency_Histogram to_displayed;
+
+    public:
+        // keys, a bitmask, went down in the frontend's input
+        void key_arrived(unsigned short keys);
+        // the machine ran; before and after are its counters around the run
+        void machine_ran(const Chip8_Counters& before, const Chip8_Counters& after);
+        // the frontend finished presenting a frame
+        void frame_displayed();
+
+        void print(FILE* out) const;
+
+    private:
+        double elapsed_ms() const;
+};
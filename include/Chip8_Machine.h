@@ -0,0 +1,128 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "Chip8_Frame.h"
+#include "Chip8_Trace.h"
+
+enum class Chip8_Variant {
+    CHIP_8,
+    SUPER_CHIP,
+    XO_CHIP,
+};
+
+enum class Chip8_Quirk_Set {
+    MODERN,
+    COWGOD,
+    VIP,
+    SUPER_CHIP,
+    XO_CHIP,
+};
+
+// INSTRUCTIONS charges one cycle per instruction; VIP charges COSMAC VIP
+// machine cycles and is only available for CHIP-8
+enum class Chip8_Timing_Model {
+    INSTRUCTIONS,
+    VIP,
+};
+
+// Why a machine stopped on its own. A faulted machine is halted and stays
+// that way; execution never reads or writes outside its own state.
+enum class Chip8_Fault {
+    NONE,
+    STACK_OVERFLOW,
+    STACK_UNDERFLOW,
+};
+
+// Running totals a frontend can compare between frames. keys_seen[k] counts
+// EX9E/EXA1/FX0A finding key k held down, sprites_drawn counts DXYN and
+// idle_cycles the cycles spent halted, waiting for a key or going round a
+// jump-to-self or delay timer loop. invalid_instructions counts instructions
+// the platform does not have, which are skipped.
+struct Chip8_Counters {
+    unsigned long long keys_seen[16];
+    unsigned long long sprites_drawn;
+    unsigned long long cycles;
+    unsigned long long idle_cycles;
+    unsigned long long invalid_instructions;
+};
+
+// The CPU side of a machine's state, for tools that compare or show it.
+// key_register is the register FX0A is waiting to fill, or 0xFF.
+struct Chip8_Cpu_State {
+    unsigned char registers[16];
+    unsigned short index_register;
+    unsigned short program_counter;
+    unsigned char stack_pointer;
+    unsigned char delay_timer;
+    unsigned char sound_timer;
+    unsigned char key_register;
+    bool halted;
+};
+
+// Run time interface to a Chip8_Core of any platform and quirk set, so
+// frontends can pick the machine per ROM. Only whole operations are virtual;
+// the instruction loop inside the core is not.
+class Chip8_Machine {
+    public:
+        bool draw_flag = 1;
+
+    public:
+        virtual ~Chip8_Machine() {}
+
+        // false, after saying why, if the file cannot be opened
+        virtual bool load_rom_to_memory(std::string) = 0;
+        // copies a ROM already in memory to 0x200, cut off at the end of memory
+        virtual void load_rom(const unsigned char* bytes, size_t size) = 0;
+        // the same, but leaves the program counter and everything else as
+        // it is, to put new code into a machine that is already running
+        virtual void patch_rom(const unsigned char* bytes, size_t size) = 0;
+        virtual void complete_one_instruction() = 0;
+        virtual void run_instructions(unsigned int count) = 0;
+        // runs up to and including the next timer tick
+        virtual void run_frame() = 0;
+
+        // 0 is ignored, since the next tick would never come
+        virtual void set_cycles_per_tick(unsigned int cycles) = 0;
+        virtual unsigned int get_cycles_per_tick() = 0;
+        virtual unsigned long long get_cycles() = 0;
+
+        virtual void set_keypad(unsigned short keys) = 0;
+        virtual unsigned short get_keypad() = 0;
+
+        virtual bool is_sound_on() = 0;
+        virtual const unsigned char* get_audio_pattern() = 0;
+        virtual unsigned char get_pitch() = 0;
+        virtual bool is_halted() = 0;
+        virtual Chip8_Fault get_fault() = 0;
+        virtual Chip8_Counters get_counters() = 0;
+
+        virtual Frame_View get_frame_view() const = 0;
+
+        virtual Chip8_Cpu_State get_cpu_state() const = 0;
+        virtual unsigned char read_memory(unsigned short address) const = 0;
+        // Hash of everything that decides what the machine does next: the
+        // CPU state, the random generator, the stack in use, memory and the
+        // frame buffer, plus the extra state of SUPER-CHIP and XO-CHIP. Equal
+        // machines of the same kind hash equal; counters, timing and the
+        // keypad are left out. Memory and the frame buffer keep running
+        // hashes, so this costs the same whatever their size.
+        virtual uint64_t hash_state() const = 0;
+        // XOR of element_hash(word index, word) over the frame buffer words,
+        // updated as it is drawn to
+        virtual uint64_t get_frame_hash() const = 0;
+        virtual Chip8_Trace_Policy& get_trace() = 0;
+
+        // Save states and branching. fork() makes an independent copy of the
+        // machine and copy_state_from(other) makes this machine an exact copy
+        // of other, which must be the same kind of machine. Main memory is
+        // shared copy-on-write, so both copy registers, the frame buffer and
+        // a page table, and a later write copies only the page it touches.
+        virtual std::unique_ptr<Chip8_Machine> fork() const = 0;
+        virtual void copy_state_from(const Chip8_Machine& other) = 0;
+        // the same as copy_state_from, but copies memory into pages this
+        // machine keeps to itself, so going back to one snapshot over and
+        // over, as environments resetting episodes do, allocates nothing
+        virtual void restore_state_from(const Chip8_Machine& other) = 0;
+};
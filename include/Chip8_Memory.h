@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <cstring>
+#include "constants.h"
+#include "Chip8_Hash.h"
+
+// Main memory split into MEMORY_PAGE_BYTES pages that copies share until
+// one of them writes. Copying costs a page table and a reference count per
+// page; a write to a shared page first gives the writer its own copy.
+// Reference counts are atomic so copies can run on different threads.
+// Addresses wrap around the memory size. A running hash of the contents is
+// kept up to date on every write.
+template <int BYTES>
+class Paged_Memory {
+    private:
+        static constexpr int PAGES = BYTES / MEMORY_PAGE_BYTES;
+        static_assert(BYTES % MEMORY_PAGE_BYTES == 0 && (BYTES & (BYTES - 1)) == 0,
+                      "memory must be a power of two number of pages");
+
+        struct Page {
+            std::atomic<unsigned int> references;
+            unsigned char bytes[MEMORY_PAGE_BYTES];
+        };
+        Page* pages[PAGES];
+        uint64_t hash = 0;
+
+    public:
+        // every page starts out as the same zero page
+        Paged_Memory() {
+            Page* zero = new Page;
+            zero->references.store(PAGES, std::memory_order_relaxed);
+            memset(zero->bytes, 0, sizeof(zero->bytes));
+            for (int i = 0; i < PAGES; i++) {
+                pages[i] = zero;
+            }
+        }
+        Paged_Memory(const Paged_Memory& other) : hash(other.hash) {
+            for (int i = 0; i < PAGES; i++) {
+                pages[i] = other.pages[i];
+                pages[i]->references.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        Paged_Memory& operator=(const Paged_Memory& other) {
+            for (int i = 0; i < PAGES; i++) {
+                // take the new reference first so assigning to itself is safe
+                other.pages[i]->references.fetch_add(1, std::memory_order_relaxed);
+                release(pages[i]);
+                pages[i] = other.pages[i];
+            }
+            hash = other.hash;
+            return *this;
+        }
+        ~Paged_Memory() {
+            for (int i = 0; i < PAGES; i++) {
+                release(pages[i]);
+            }
+        }
+
+        inline unsigned char operator[](unsigned int address) const {
+            address &= BYTES - 1;
+            return pages[address / MEMORY_PAGE_BYTES]->bytes[address % MEMORY_PAGE_BYTES];
+        }
+
+        inline void write(unsigned int address, unsigned char value) {
+            address &= BYTES - 1;
+            Page*& page = pages[address / MEMORY_PAGE_BYTES];
+            // acquire pairs with the release in release(), so the copies that
+            // dropped their references have finished reading the page
+            if (page->references.load(std::memory_order_acquire) != 1) {
+                unshare(page);
+            }
+            unsigned char& byte = page->bytes[address % MEMORY_PAGE_BYTES];
+            hash ^= element_hash(address, byte) ^ element_hash(address, value);
+            byte = value;
+        }
+
+        // Copies other's bytes into pages this memory owns alone, rather
+        // than sharing other's. Only pages still shared are allocated, so
+        // restoring the same snapshot again and again allocates nothing
+        // after the first time.
+        void copy_bytes_from(const Paged_Memory& other) {
+            for (int i = 0; i < PAGES; i++) {
+                if (pages[i]->references.load(std::memory_order_acquire) != 1) {
+                    unshare(pages[i]);
+                }
+                memcpy(pages[i]->bytes, other.pages[i]->bytes, sizeof(pages[i]->bytes));
+            }
+            hash = other.hash;
+        }
+
+        // XOR of element_hash(address, byte) over every byte
+        inline uint64_t get_hash() const { return hash; }
+
+    private:
+        static inline void release(Page* page) {
+            if (page->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete page;
+            }
+        }
+
+        static void unshare(Page*& page) {
+            Page* copy = new Page;
+            copy->references.store(1, std::memory_order_relaxed);
+            memcpy(copy->bytes, page->bytes, sizeof(copy->bytes));
+            release(page);
+            page = copy;
+        }
+};
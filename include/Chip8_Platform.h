@@ -0,0 +1,43 @@
+#pragma once
+
+// Compile time description of the machine a Chip8_Core emulates. The frame
+// buffer is always FRAME_WIDTH x FRAME_HEIGHT; variants with a low
+// resolution mode draw it at LORES_SCALE x LORES_SCALE pixels per pixel.
+// PLANES frame buffers are drawn to independently and combined into a
+// colour index per pixel.
+
+// The original COSMAC VIP interpreter
+struct Chip8_Platform {
+    static constexpr int FRAME_WIDTH = 64;
+    static constexpr int FRAME_HEIGHT = 32;
+    static constexpr int LORES_SCALE = 1;
+    static constexpr int PLANES = 1;
+    static constexpr int MEMORY_BYTES = 4096;
+    static constexpr bool SUPER_CHIP = false;
+    static constexpr bool XO_CHIP = false;
+};
+
+// SUPER-CHIP 1.1: 128x64 high resolution mode, 16x16 sprites, scrolling,
+// a big font and RPL user flags
+struct Super_Chip_Platform {
+    static constexpr int FRAME_WIDTH = 128;
+    static constexpr int FRAME_HEIGHT = 64;
+    static constexpr int LORES_SCALE = 2;
+    static constexpr int PLANES = 1;
+    static constexpr int MEMORY_BYTES = 4096;
+    static constexpr bool SUPER_CHIP = true;
+    static constexpr bool XO_CHIP = false;
+};
+
+// XO-CHIP: SUPER-CHIP plus 64 KB of memory (F000 NNNN), two bitplanes
+// (FN01), register range save/load (5XY2/5XY3), scrolling up (00DN) and an
+// audio pattern buffer (F002, FX3A)
+struct Xo_Chip_Platform {
+    static constexpr int FRAME_WIDTH = 128;
+    static constexpr int FRAME_HEIGHT = 64;
+    static constexpr int LORES_SCALE = 2;
+    static constexpr int PLANES = 2;
+    static constexpr int MEMORY_BYTES = 65536;
+    static constexpr bool SUPER_CHIP = true;
+    static constexpr bool XO_CHIP = true;
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "Chip8_Machine.h"
+#include "constants.h"
+
+// How a particular ROM should be run
+struct Rom_Profile {
+    Chip8_Variant variant;
+    Chip8_Quirk_Set quirks;
+    unsigned int instructions_per_frame;
+    std::string name;
+};
+
+// 64 bit FNV-1a of the whole ROM file, 0 if it cannot be read
+uint64_t hash_rom(const std::string& rom_file_name);
+
+// ROM hash -> profile, read from a text file such as roms/profiles.txt
+class Rom_Profile_Database {
+    private:
+        std::unordered_map<uint64_t, Rom_Profile> profiles;
+
+    public:
+        bool load(const std::string& file_name);
+        const Rom_Profile* find(uint64_t hash) const;
+
+        // the listed profile for the ROM, or one built from detect_variant
+        Rom_Profile profile_for(const std::string& rom_file_name) const;
+};
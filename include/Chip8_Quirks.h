@@ -0,0 +1,59 @@
+#pragma once
+
+// Compile time behaviour differences between CHIP-8 interpreters. Each quirk
+// set is a separate specialization of Chip8_Core, so instructions test these
+// with `if constexpr` and never check a flag at run time.
+//
+//   SHIFT_USES_VY            8XY6/8XYE shift Vy into Vx instead of shifting Vx
+//   LOAD_STORE_INCREMENTS_I  Fx55/Fx65 leave I pointing past the last register
+//   JUMP_USES_VX             BXNN jumps to XNN + Vx instead of BNNN to NNN + V0
+//   CLIP_SPRITES             sprites are cut off at the screen edges instead of
+//                            wrapping around (the start position still wraps)
+//   LOGIC_RESETS_VF          8XY1/8XY2/8XY3 set VF to 0
+
+// What this emulator has always done, and what most modern CHIP-8 games
+// written against Cowgod's reference expect
+struct Modern_Quirks {
+    static constexpr bool SHIFT_USES_VY = false;
+    static constexpr bool LOAD_STORE_INCREMENTS_I = true;
+    static constexpr bool JUMP_USES_VX = false;
+    static constexpr bool CLIP_SPRITES = false;
+    static constexpr bool LOGIC_RESETS_VF = false;
+};
+
+// Cowgod's technical reference taken literally: the same as Modern_Quirks
+// except that Fx55/Fx65 leave I alone, which ROMs such as c8_test check
+struct Cowgod_Quirks {
+    static constexpr bool SHIFT_USES_VY = false;
+    static constexpr bool LOAD_STORE_INCREMENTS_I = false;
+    static constexpr bool JUMP_USES_VX = false;
+    static constexpr bool CLIP_SPRITES = false;
+    static constexpr bool LOGIC_RESETS_VF = false;
+};
+
+// The original COSMAC VIP interpreter
+struct Vip_Quirks {
+    static constexpr bool SHIFT_USES_VY = true;
+    static constexpr bool LOAD_STORE_INCREMENTS_I = true;
+    static constexpr bool JUMP_USES_VX = false;
+    static constexpr bool CLIP_SPRITES = true;
+    static constexpr bool LOGIC_RESETS_VF = true;
+};
+
+// SUPER-CHIP 1.1 on the HP 48
+struct Super_Chip_Quirks {
+    static constexpr bool SHIFT_USES_VY = false;
+    static constexpr bool LOAD_STORE_INCREMENTS_I = false;
+    static constexpr bool JUMP_USES_VX = true;
+    static constexpr bool CLIP_SPRITES = true;
+    static constexpr bool LOGIC_RESETS_VF = false;
+};
+
+// XO-CHIP as implemented by Octo
+struct Xo_Chip_Quirks {
+    static constexpr bool SHIFT_USES_VY = true;
+    static constexpr bool LOAD_STORE_INCREMENTS_I = true;
+    static constexpr bool JUMP_USES_VX = false;
+    static constexpr bool CLIP_SPRITES = false;
+    static constexpr bool LOGIC_RESETS_VF = false;
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "constants.h"
+#include "Chip8_Machine.h"
+
+// Watches a ROM file and, when it is rewritten, puts the new ROM into the
+// running machine in place, so the frontend's window, frame view and sound
+// device carry on. The directory is watched rather than the file, so
+// assemblers that write a new file and rename it over the old one are
+// caught too. Uses inotify on Linux and checks the modification time
+// elsewhere.
+//
+// Without replay the new ROM starts from the beginning. With replay the
+// reloader records every frame's keys and cycles per tick, and runs the new
+// ROM through the same frames and input before handing it over, so a
+// change shows up at the point of the game it was made for. Every
+// checkpoint_frames frames it forks the running machine and forgets the
+// input before; later reloads copy the new ROM over that checkpoint and
+// replay from there, so neither the history nor a reload's cost grows
+// with the length of the session.
+class Rom_Reloader {
+    private:
+        struct Recorded_Frame {
+            unsigned short keys;
+            unsigned int cycles_per_tick;
+        };
+
+        std::string path;
+        // builds an empty machine of the same kind as the running one
+        std::function<std::unique_ptr<Chip8_Machine>()> make_machine;
+        bool replay;
+        unsigned int checkpoint_frames;
+        // the machine the recorded frames start from; none means a fresh one
+        std::unique_ptr<Chip8_Machine> checkpoint;
+        std::vector<Recorded_Frame> frames;
+
+        int inotify_fd = -1;
+        std::string file_name;
+        long long modified_ns = 0;
+
+    public:
+        Rom_Reloader(const std::string& path, std::function<std::unique_ptr<Chip8_Machine>()> make_machine,
+                     bool replay, unsigned int checkpoint_frames = RELOAD_CHECKPOINT_FRAMES);
+        ~Rom_Reloader();
+
+        // call before each frame the machine runs
+        void record_frame(Chip8_Machine& chip8);
+
+        // Cheap enough to call on every pass of the frontend loop. Returns
+        // true if the ROM changed and chip8 now runs the new one.
+        bool reload_if_changed(Chip8_Machine& chip8);
+
+    private:
+        bool has_changed();
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdio>
+#include <deque>
+#include <vector>
+#include "Chip8_Backend.h"
+#include "Chip8_Frame.h"
+#include "Chip8_Latency.h"
+#include "Chip8_Machine.h"
+#include "Chip8_Reload.h"
+#include "Chip8_Shared.h"
+
+// The emulator always advances a whole frame (one timer tick of virtual
+// time) at a time; the mode only decides when the next one starts.
+// WALL_CLOCK starts TIMER_HZ frames per host second. AUDIO starts one each
+// time the backend's beeper needs another frame of samples, so the sound
+// device's clock sets the speed and the queue of samples can neither run dry
+// nor grow. UNTHROTTLED runs frames back to back.
+enum class Sync_Mode {
+    WALL_CLOCK,
+    AUDIO,
+    UNTHROTTLED
+};
+
+// What the runner has been doing, for frontends to show
+struct Run_Stats {
+    unsigned long long frames = 0;
+    unsigned int cycles_per_tick = 0;
+    // share of the last ADAPTIVE_SETTLE_FRAMES frames spent in idle loops
+    double idle_fraction = 0;
+    // in audio synced mode, how far rate control stretches frames' samples
+    bool audio_synced = false;
+    double audio_rate_ppm = 0;
+    // (frame, cycles per tick) each time adaptive mode changed it, the last
+    // RUN_STATS_HISTORY changes only
+    std::deque<std::pair<unsigned long long, unsigned int>> history;
+
+    void print(FILE* out) const;
+};
+
+struct Run_Options {
+    // AUDIO falls back to WALL_CLOCK for backends without a beeper
+    Sync_Mode sync = Sync_Mode::WALL_CLOCK;
+    // With run_ahead N, each frame is followed by N more frames on the same
+    // input whose result is what gets shown; the machine is then put back to
+    // where it was. Games react to input N frames sooner than they would.
+    unsigned int run_ahead = 0;
+    // measures input latency when set
+    Latency_Monitor* latency = nullptr;
+    // Adaptive mode lowers cycles per tick while the ROM idles through most
+    // of its frames and raises them again when it stops idling, within
+    // [min_cycles_per_tick, max_cycles_per_tick]. Zero bounds default to a
+    // quarter and twice the machine's starting value. ROMs that never idle
+    // keep their starting value.
+    bool adaptive = false;
+    unsigned int min_cycles_per_tick = 0;
+    unsigned int max_cycles_per_tick = 0;
+    // kept up to date every frame when set
+    Run_Stats* stats = nullptr;
+    // when set, every frame is published to it and the keys held in it are
+    // added to the backend's
+    Shared_Frame_Export* shared = nullptr;
+    // when set, a rewritten ROM file is loaded into the machine as it runs
+    Rom_Reloader* reloader = nullptr;
+};
+
+// Runs chip8 frame by frame until the backend closes. Every sink receives
+// the frame buffer once per frame.
+void run_emulator(Chip8_Machine& chip8, Chip8_Backend& backend,
+                  const std::vector<Frame_Sink*>& sinks = {}, const Run_Options& options = {});
@@ -0,0 +1,56 @@
+#pragma once
+#include <memory>
+#include "Chip8_Machine.h"
+#include "Chip8_Reload.h"
+#include "Chip8_Runner.h"
+#include "Chip8_Shared.h"
+#include "constants.h"
+
+// The command line options chip-8 and chip-8-headless have in common
+struct Session_Options {
+    const char* rom = nullptr;
+    const char* profiles_file = DEFAULT_PROFILES_FILE;
+    // given ones override the ROM's profile
+    bool variant_given = false;
+    Chip8_Variant variant;
+    bool quirks_given = false;
+    Chip8_Quirk_Set quirks;
+    unsigned int instructions_per_frame = 0;
+    Chip8_Timing_Model timing = Chip8_Timing_Model::INSTRUCTIONS;
+
+    const char* timeline_file = nullptr;
+    const char* shared_name = nullptr;
+    bool print_stats = false;
+    bool watch = false;
+    bool watch_replay = false;
+    // Session::start fills in stats, shared and reloader
+    Run_Options run;
+
+    // Takes argv[i], and the value after it if it has one, when it is one
+    // of the options above; false leaves it to the frontend, as does a
+    // value that is out of range or not a number.
+    bool parse(int argc, char** argv, int& i);
+};
+
+// The machine a frontend runs and what runs alongside it: the ROM's
+// profile with the overrides on top, the trace file of CHIP8_TRACE builds,
+// the reloader and the shared memory export.
+class Session {
+    private:
+        Session_Options& options;
+        std::unique_ptr<Rom_Reloader> reloader;
+        std::unique_ptr<Shared_Frame_Export> shared;
+
+    public:
+        std::unique_ptr<Chip8_Machine> chip8;
+        Run_Stats stats;
+
+        Session(Session_Options& options) : options(options) {}
+
+        // builds and loads the machine and starts the timeline if one was
+        // asked for; false, after saying why, if the machine cannot run
+        bool start();
+        // writes the timeline; call once run_emulator has returned and the
+        // sinks' threads are done
+        void finish();
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Chip8_Frame.h"
+
+// Layout of the shared memory segment, for readers in any language. All
+// fields are little endian as the host stores them:
+//
+//   offset  0  uint32  magic, SHARED_FRAME_MAGIC
+//   offset  4  uint32  version, SHARED_FRAME_VERSION
+//   offset  8  uint32  sequence, odd while the emulator writes a frame
+//   offset 12  uint32  keypad, bit i holds key i down; written by readers
+//   offset 16  uint64  frame, frames published so far
+//   offset 24  uint32  width, height, words_per_row, planes (one each)
+//   offset 64  uint64  rows, planes * height * words_per_row words packed
+//                      as in Frame_View
+//
+// frame and rows are a seqlock: read sequence, copy them, read sequence
+// again, and keep the copy if both reads were the same even number.
+struct Shared_Frame_Header {
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> keypad;
+    uint64_t frame;
+    uint32_t width;
+    uint32_t height;
+    uint32_t words_per_row;
+    uint32_t planes;
+};
+
+const uint32_t SHARED_FRAME_MAGIC = 0x42463843; // "C8FB"
+const uint32_t SHARED_FRAME_VERSION = 1;
+const size_t SHARED_FRAME_ROWS_OFFSET = 64;
+
+// Publishes every frame, the frame count and a keypad other processes can
+// press keys on through a POSIX shared memory segment (/dev/shm/<name> on
+// Linux), so bots and tools can watch and play without linking the
+// emulator. Publishing copies the frame once and never blocks; a reader
+// that loses the race to a new frame just copies again.
+class Shared_Frame_Export {
+    private:
+        std::string name;
+        Shared_Frame_Header* header = nullptr;
+        uint64_t* rows = nullptr;
+        size_t size = 0;
+        size_t row_words = 0;
+
+    public:
+        // name is the shm_open name, with or without the leading '/'
+        Shared_Frame_Export(const std::string& name, const Frame_View& frame);
+        // unmaps and removes the segment
+        ~Shared_Frame_Export();
+
+        inline bool is_open() const { return header != nullptr; }
+
+        void publish(const Frame_View& frame);
+
+        // keys readers are holding down, as a keypad bitmask
+        inline unsigned short get_keypad() const {
+            return header == nullptr ? 0 : (unsigned short)header->keypad.load(std::memory_order_relaxed);
+        }
+};
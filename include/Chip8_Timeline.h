@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+
+// Optional timeline of where frame time goes, written as Chrome trace event
+// JSON (chrome://tracing, ui.perfetto.dev). Code marks phases with a
+// Timeline_Scope; while the timeline is off a scope costs one branch.
+// Every thread appends to its own preallocated buffer, so recording never
+// takes a lock or allocates after a thread's first event.
+class Timeline {
+    public:
+        static std::atomic<bool> enabled;
+
+        // starts recording; timestamps are relative to this call
+        static void start();
+        // writes everything recorded so far; call it once the instrumented
+        // threads have finished
+        static bool write(const char* path);
+
+        static void record(const char* name, long long start_ns, long long end_ns);
+
+        static inline long long now_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+};
+
+class Timeline_Scope {
+    private:
+        const char* name;
+        long long start_ns;
+
+    public:
+        // name must outlive the timeline, a string literal in practice
+        inline Timeline_Scope(const char* name)
+            : name(name), start_ns(Timeline::enabled.load(std::memory_order_relaxed) ? Timeline::now_ns() : 0) {}
+        inline ~Timeline_Scope() {
+            if (Timeline::enabled.load(std::memory_order_relaxed)) {
+                Timeline::record(name, start_ns, Timeline::now_ns());
+            }
+        }
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include "constants.h"
+
+// Compile time cost model of Chip8_Core. cycles() is charged for every
+// instruction before it runs (so it sees the registers the instruction will
+// read), IDLE_CYCLES pass for every step a halted or key waiting machine
+// makes, INTERRUPT_CYCLES are taken from every frame for the display, and
+// with DISPLAY_WAIT a DXYN first waits for the next frame to start.
+// Instruction_Timing folds to a constant 1, so the default cores pay nothing
+// for the model.
+
+// One cycle per instruction; cycles per tick is the ROM's instructions per
+// frame
+struct Instruction_Timing {
+    static constexpr unsigned int CYCLES_PER_TICK = DEFAULT_INSTRUCTIONS_PER_FRAME;
+    static constexpr unsigned int IDLE_CYCLES = 1;
+    static constexpr unsigned int INTERRUPT_CYCLES = 0;
+    static constexpr bool DISPLAY_WAIT = false;
+
+    static constexpr unsigned int cycles(unsigned short, const unsigned char*) { return 1; }
+};
+
+// The original COSMAC VIP interpreter, counted in 1802 machine cycles (8
+// clocks at 1.7609 MHz, 3668 per 60 Hz frame). The display DMA and interrupt
+// routine take 1024 + 30 of those every frame. Costs are the interpreter's
+// fetch and dispatch plus the instruction's own routine, rounded from
+// published measurements, so they are close but not exact.
+struct Vip_Timing {
+    static constexpr unsigned int CYCLES_PER_TICK = 3668;
+    static constexpr unsigned int FETCH_CYCLES = 40;
+    // one pass of the FX0A keyboard scan
+    static constexpr unsigned int IDLE_CYCLES = FETCH_CYCLES + 10;
+    static constexpr unsigned int INTERRUPT_CYCLES = 1054;
+    static constexpr bool DISPLAY_WAIT = true;
+
+    static constexpr unsigned int cycles(unsigned short instruction, const unsigned char* registers) {
+        unsigned char X = (instruction >> 8) & 0xF;
+        unsigned char Y = (instruction >> 4) & 0xF;
+        unsigned char NN = instruction & 0xFF;
+        unsigned char N = instruction & 0xF;
+
+        switch (instruction >> 12) {
+            case 0x0:
+                return FETCH_CYCLES + (instruction == 0x00E0u ? 24 : 23);
+            case 0x1:
+            case 0x2:
+            case 0xB:
+                return FETCH_CYCLES + 23;
+            // skips cost a little more when taken
+            case 0x3:
+                return FETCH_CYCLES + 12 + (registers[X] == NN ? 2 : 0);
+            case 0x4:
+                return FETCH_CYCLES + 12 + (registers[X] != NN ? 2 : 0);
+            case 0x5:
+                return FETCH_CYCLES + 16 + (registers[X] == registers[Y] ? 2 : 0);
+            case 0x9:
+                return FETCH_CYCLES + 16 + (registers[X] != registers[Y] ? 2 : 0);
+            case 0x6:
+                return FETCH_CYCLES + 6;
+            case 0x7:
+                return FETCH_CYCLES + 10;
+            case 0x8:
+                return FETCH_CYCLES + 44;
+            case 0xA:
+                return FETCH_CYCLES + 12;
+            case 0xC:
+                return FETCH_CYCLES + 36;
+            // every row is shifted into place, which is slower when the
+            // sprite does not start on a byte boundary
+            case 0xD:
+                return FETCH_CYCLES + 26 + N * ((registers[X] & 7) == 0 ? 15 : 24);
+            case 0xE:
+                return FETCH_CYCLES + 16;
+            case 0xF:
+                switch (NN) {
+                    case 0x1E:
+                        return FETCH_CYCLES + 19;
+                    case 0x29:
+                        return FETCH_CYCLES + 20;
+                    // BCD is done by repeated subtraction
+                    case 0x33:
+                        return FETCH_CYCLES + 16 * (registers[X] / 100 + registers[X] / 10 % 10 + registers[X] % 10);
+                    case 0x55:
+                    case 0x65:
+                        return FETCH_CYCLES + 14 + 14 * (X + 1);
+                    default:
+                        return FETCH_CYCLES + 10;
+                }
+        }
+        return FETCH_CYCLES;
+    }
+};
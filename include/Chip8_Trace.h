@@ -0,0 +1,124 @@
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// One executed instruction. changed_registers has bit i set when Vi was
+// written by the instruction; registers holds the values after it ran.
+struct Trace_Record {
+    unsigned short program_counter;
+    unsigned short instruction;
+    unsigned short index_register;
+    unsigned short changed_registers;
+    unsigned char registers[16];
+};
+
+// A trace file is a Trace_File_Header followed by Trace_Records back to back,
+// so readers can mmap it and index records directly.
+const char TRACE_FILE_MAGIC[8] = {'C', '8', 'T', 'R', 'A', 'C', 'E', 0};
+const unsigned int TRACE_FILE_VERSION = 1;
+
+struct Trace_File_Header {
+    char magic[8];
+    unsigned int version;
+    unsigned int record_size;
+};
+
+// Tracing is a compile time policy of Chip8_Core. The core only touches the
+// policy inside `if constexpr (Trace_Policy::ENABLED)`, so a core built with
+// No_Trace contains no trace code at all.
+struct No_Trace {
+    static constexpr bool ENABLED = false;
+
+    inline void record(unsigned short, unsigned short, unsigned short,
+                       const unsigned char*, const unsigned char*) {}
+};
+
+// Keeps the last CAPACITY instructions in memory, overwriting the oldest.
+// When a file is attached, every full buffer is appended to it before being
+// overwritten, so the file ends up holding the whole run. Assigning an
+// earlier trace, as restoring a run-ahead snapshot does, cuts the file back
+// to it, so instructions that were taken back never stay in the file.
+class Ring_Buffer_Trace {
+    public:
+        static constexpr bool ENABLED = true;
+        static constexpr unsigned int CAPACITY = 1u << 16;
+
+    private:
+        std::vector<Trace_Record> records;
+        unsigned long long total = 0;
+
+        FILE* file = nullptr;
+        // total when the file was opened, and when it was last written
+        unsigned long long file_start = 0;
+        unsigned long long flushed = 0;
+
+    public:
+        Ring_Buffer_Trace() : records(CAPACITY) {}
+        // copies share the recorded history but never the attached file
+        Ring_Buffer_Trace(const Ring_Buffer_Trace& other) : records(other.records), total(other.total) {}
+        Ring_Buffer_Trace& operator=(const Ring_Buffer_Trace& other) {
+            records = other.records;
+            total = other.total;
+            if (file != nullptr && flushed > total) {
+                rewind_file();
+            }
+            return *this;
+        }
+        ~Ring_Buffer_Trace();
+
+        bool open_file(const char* path);
+        void close_file();
+
+        inline void record(unsigned short program_counter, unsigned short instruction,
+                           unsigned short index_register,
+                           const unsigned char* registers_before,
+                           const unsigned char* registers_after) {
+            Trace_Record& r = records[total & (CAPACITY - 1)];
+            r.program_counter = program_counter;
+            r.instruction = instruction;
+            r.index_register = index_register;
+            r.changed_registers = 0;
+            for (int i = 0; i < 16; i++) {
+                r.changed_registers |= (unsigned short)((registers_before[i] != registers_after[i]) << i);
+            }
+            memcpy(r.registers, registers_after, 16);
+            total++;
+            if (file != nullptr && (total & (CAPACITY - 1)) == 0) {
+                flush_file();
+            }
+        }
+
+        inline unsigned long long get_total() const { return total; }
+        inline unsigned int size() const { return total < CAPACITY ? (unsigned int)total : CAPACITY; }
+
+        // i = 0 is the oldest record still held in the buffer
+        inline const Trace_Record& at(unsigned int i) const {
+            return records[(total - size() + i) & (CAPACITY - 1)];
+        }
+
+        void dump(FILE* out, unsigned int last = CAPACITY) const {
+            unsigned int count = size() < last ? size() : last;
+            for (unsigned int i = size() - count; i < size(); i++) {
+                const Trace_Record& r = at(i);
+                fprintf(out, "0x%03x: 0x%04x I=0x%03x", r.program_counter, r.instruction, r.index_register);
+                for (int k = 0; k < 16; k++) {
+                    if (r.changed_registers & (1u << k)) {
+                        fprintf(out, " V%x=0x%02x", k, r.registers[k]);
+                    }
+                }
+                fprintf(out, "\n");
+            }
+        }
+
+    private:
+        void flush_file();
+        void rewind_file();
+};
+
+// Builds configured with -DCHIP8_TRACE=ON record every instruction
+#ifdef CHIP8_TRACE
+using Chip8_Trace_Policy = Ring_Buffer_Trace;
+#else
+using Chip8_Trace_Policy = No_Trace;
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Chip8_Frame.h"
+
+enum class Video_Format {
+    NONE,
+    // 8 bit grayscale frames back to back (ffmpeg -f rawvideo -pix_fmt gray)
+    RAW,
+    // YUV4MPEG2 4:2:0 stream, playable by ffmpeg/mpv directly
+    Y4M,
+};
+
+struct Video_Options {
+    Video_Format format = Video_Format::NONE;
+    // "-" writes the stream to stdout
+    std::string path = "-";
+    // every emulated pixel becomes scale x scale output pixels
+    int scale = 1;
+    // also write <png_prefix><frame>.png every png_every frames (0 disables)
+    unsigned int png_every = 0;
+    std::string png_prefix = "frame_";
+    // frames waiting for the encoder; more than this are dropped, or wait
+    // for the encoder when drop_when_full is off
+    unsigned int queue_frames = 64;
+    bool drop_when_full = true;
+};
+
+// Writes emulated frames to a video stream and/or PNG snapshots. Frames are
+// copied into a bounded queue on the emulation thread and encoded on a
+// background thread, so a slow disk or pipe costs dropped frames rather
+// than emulation speed. Unthrottled runs turn dropping off and let the
+// encoder set the pace instead.
+class Video_Exporter : public Frame_Sink {
+    private:
+        Video_Options options;
+        int width;
+        int height;
+        FILE* stream = nullptr;
+
+        std::vector<std::vector<unsigned char>> slots;
+        std::vector<unsigned long long> slot_numbers;
+        unsigned int head = 0;
+        unsigned int count = 0;
+        unsigned long long submitted = 0;
+        unsigned long long dropped = 0;
+        bool stopping = false;
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::condition_variable space;
+        std::thread encoder;
+
+        std::vector<unsigned char> scaled;
+
+    public:
+        Video_Exporter(const Video_Options& options, int width, int height);
+        ~Video_Exporter();
+
+        void submit_frame(const Frame_View& frame) override;
+
+        inline unsigned long long get_dropped() { return dropped; }
+
+    private:
+        void encode_loop();
+        void encode(const std::vector<unsigned char>& frame, unsigned long long number);
+};
+
+// Writes width x height 8 bit gray pixels, row by row, as a PNG
+bool write_png(const std::string& path, const unsigned char* pixels, int width, int height);
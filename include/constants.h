@@ -1,30 +1,10 @@
 #pragma once
-#include <map>
-#include <SFML/Window/Keyboard.hpp>
 
-const int PIXELS_HEIGHT = 32;
-const int PIXELS_WIDTH = 64;
-
-const int MEMORY_BYTES = 4096;
 const int STACK_BYTES = 64;
-const std::map<unsigned char, sf::Keyboard::Key> CHIP_8_KEYS = {
-    {0x00, sf::Keyboard::X},
-    {0x01, sf::Keyboard::Num1},
-    {0x02, sf::Keyboard::Num2},
-    {0x03, sf::Keyboard::Num3},
-    {0x04, sf::Keyboard::Q},
-    {0x05, sf::Keyboard::W},
-    {0x06, sf::Keyboard::E},
-    {0x07, sf::Keyboard::A},
-    {0x08, sf::Keyboard::S},
-    {0x09, sf::Keyboard::D},
-    {0x0A, sf::Keyboard::Z},
-    {0x0B, sf::Keyboard::C},
-    {0x0C, sf::Keyboard::Num4},
-    {0x0D, sf::Keyboard::R},
-    {0x0E, sf::Keyboard::F},
-    {0x0F, sf::Keyboard::V},
-};
+
+// Main memory is shared between forked machines in pages of this size,
+// and a page is copied the first time a fork writes to it
+const int MEMORY_PAGE_BYTES = 256;
 
 const int PRESET_DIGIT_SPRITES_SIZE = 80;
 
@@ -47,8 +27,89 @@ const unsigned char PRESET_DIGIT_SPRITES[PRESET_DIGIT_SPRITES_SIZE] = {
     0xF0, 0x80, 0xF0, 0x80, 0x80  // F
 };
 
-const bool DEBUG = false;
+const int BIG_DIGIT_SPRITES_START = 0x50;
+const int PRESET_BIG_DIGIT_SPRITES_SIZE = 160;
+
+// SUPER-CHIP 8x10 digits, drawn in high resolution mode
+const unsigned char PRESET_BIG_DIGIT_SPRITES[PRESET_BIG_DIGIT_SPRITES_SIZE] = {
+    0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, // 0
+    0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF, // 1
+    0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // 2
+    0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 3
+    0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, // 4
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 5
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 6
+    0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18, // 7
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 8
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 9
+    0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+    0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, // B
+    0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, // C
+    0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // E
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  // F
+};
+
+const int RPL_FLAGS = 16;
+
+// CXNN draws from a per-machine xorshift generator starting here, so runs,
+// forks and replays of a ROM all see the same random numbers
+const unsigned int RANDOM_SEED = 0x2545F491u;
+
+// XO-CHIP audio: a 128 bit sample pattern played at
+// 4000 * 2 ^ ((pitch - 64) / 48) bits per second
+const int AUDIO_PATTERN_BYTES = 16;
+const int DEFAULT_AUDIO_PITCH = 64;
+
+// Beeper output. The device keeps three chunks of AUDIO_CHUNK_SAMPLES in
+// flight, refilled every AUDIO_REFILL_MS, and the emulator keeps at most
+// AUDIO_BUFFERED_SAMPLES queued behind them in either sync mode, so the
+// speaker follows the sound timer within 3 * 128 + 384 = 768 samples,
+// 17.4 ms, plus whatever the device adds. Three chunks must outlast a
+// refill and the queue must cover what one refill takes.
+const int AUDIO_SAMPLE_RATE = 44100;
+const int AUDIO_CHUNK_SAMPLES = 128;
+const int AUDIO_BUFFERED_SAMPLES = 384;
+const int AUDIO_REFILL_MS = 2;
+const int BUZZER_HZ = 440;
+const short BUZZER_AMPLITUDE = 8000;
+// In audio synced mode a frame starts once the last one's samples are all
+// queued, which leaves the queue within a device chunk of its limit, as the
+// device takes a chunk at a time. Each frame's share of samples is
+// stretched or shrunk by up to AUDIO_RATE_CONTROL (500 ppm) to keep the
+// queue at frame starts, averaged over about AUDIO_RATE_SMOOTHING frames,
+// half a chunk under the limit.
+const double AUDIO_RATE_SMOOTHING = 30;
+const double AUDIO_RATE_CONTROL = 0.0005;
 
-const int INSTRUCTION_HZ = 500;
 const int TIMER_HZ = 60;
+// used for ROMs without a profile in roms/profiles.txt
+const int DEFAULT_INSTRUCTIONS_PER_FRAME = 8;
+// the most --ipf, --ipf-min, --ipf-max and --run-ahead accept; past these a
+// frame no longer fits in 1 / TIMER_HZ seconds
+const int MAX_INSTRUCTIONS_PER_FRAME = 1000000;
+const int MAX_RUN_AHEAD = 16;
+const char* const DEFAULT_PROFILES_FILE = "roms/profiles.txt";
+
+// input latency histograms have 1 ms buckets up to this many milliseconds
+const int LATENCY_BUCKETS = 200;
+
+// A backward jump of at most this many bytes onto itself or onto an FX07 is
+// taken to be an idle loop waiting for the delay timer
+const int IDLE_LOOP_BYTES = 8;
+// Adaptive cycles per tick: lower them while more than ADAPTIVE_IDLE_HIGH of
+// recent frames is idle, raise them while less than ADAPTIVE_IDLE_LOW is
+const double ADAPTIVE_IDLE_HIGH = 0.5;
+const double ADAPTIVE_IDLE_LOW = 0.1;
+// frames the idle share is measured over before each change
+const int ADAPTIVE_SETTLE_FRAMES = 15;
+// changes of cycles per tick kept for the stats
+const int RUN_STATS_HISTORY = 256;
+
+// timeline events kept per thread, about 6 MB each
+const int TIMELINE_EVENTS_PER_THREAD = 1 << 18;
+
+// --watch-replay takes a checkpoint of the running machine this often and
+// only keeps the input since, so a reload replays at most a minute
+const int RELOAD_CHECKPOINT_FRAMES = 60 * TIMER_HZ;
 
@@ -0,0 +1,129 @@
+"""ctypes bindings for libchip8_env, a batch of CHIP-8 machines stepped
+together as a reinforcement learning environment (see include/Chip8_Env.h).
+
+    env = Chip8Env("roms/Space Invaders.ch8", batch=64, rewards=[(0x2F0, 1, 1.0)])
+    observations = env.reset()
+    observations, rewards, dones = env.step([1 << 5] * 64, n_frames=4)
+
+Actions are keypad bitmasks, bit i holding key i down. The arrays returned
+are reused by the next call; they are numpy arrays when numpy is installed
+and flat ctypes arrays otherwise. Set CHIP8_ENV_LIBRARY to the path of
+libchip8_env.so if it is not in build/ next to this directory.
+"""
+import ctypes
+import os
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+
+class _Reward(ctypes.Structure):
+    _fields_ = [("address", ctypes.c_uint16), ("size", ctypes.c_uint8), ("scale", ctypes.c_float)]
+
+
+class _Config(ctypes.Structure):
+    _fields_ = [
+        ("variant", ctypes.c_char_p),
+        ("quirks", ctypes.c_char_p),
+        ("instructions_per_frame", ctypes.c_uint),
+        ("bit_packed", ctypes.c_int),
+        ("max_pool", ctypes.c_int),
+        ("rewards", ctypes.POINTER(_Reward)),
+        ("reward_count", ctypes.c_uint),
+        ("done_address", ctypes.c_int),
+        ("done_value", ctypes.c_uint8),
+        ("max_frames", ctypes.c_ulonglong),
+    ]
+
+
+def _load_library(path):
+    if path is None:
+        path = os.environ.get("CHIP8_ENV_LIBRARY")
+    if path is None:
+        path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "build", "libchip8_env.so")
+    library = ctypes.CDLL(path)
+    library.chip8_env_create.restype = ctypes.c_void_p
+    library.chip8_env_create.argtypes = [ctypes.c_char_p, ctypes.c_size_t, ctypes.c_uint, ctypes.POINTER(_Config)]
+    library.chip8_env_destroy.argtypes = [ctypes.c_void_p]
+    library.chip8_env_observation_size.restype = ctypes.c_size_t
+    library.chip8_env_observation_size.argtypes = [ctypes.c_void_p]
+    library.chip8_env_frame_size.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_int),
+                                             ctypes.POINTER(ctypes.c_int)]
+    library.chip8_env_reset.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+    library.chip8_env_step.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_uint, ctypes.c_void_p,
+                                       ctypes.c_void_p, ctypes.c_void_p]
+    return library
+
+
+class Chip8Env:
+    """batch machines running rom. rewards is a list of (address, size,
+    scale): each step's reward is the sum of scale times the change of the
+    size byte big endian number at address. Episodes end when the machine
+    halts, when memory[done[0]] == done[1] or after max_frames frames, and
+    restart at once."""
+
+    def __init__(self, rom, batch, variant=None, quirks=None, instructions_per_frame=0, bit_packed=False,
+                 max_pool=False, rewards=(), done=None, max_frames=0, library=None):
+        self._library = _load_library(library)
+        with open(rom, "rb") as file:
+            data = file.read()
+        self._rewards = (_Reward * max(len(rewards), 1))(*[_Reward(*reward) for reward in rewards])
+        config = _Config(
+            variant.encode() if variant else None,
+            quirks.encode() if quirks else None,
+            instructions_per_frame,
+            int(bit_packed),
+            int(max_pool),
+            self._rewards,
+            len(rewards),
+            done[0] if done else -1,
+            done[1] if done else 0,
+            max_frames,
+        )
+        self._env = self._library.chip8_env_create(data, len(data), batch, ctypes.byref(config))
+        if not self._env:
+            raise ValueError("unknown variant or quirk set, a reward size other than 1 or 2, or an empty batch")
+
+        self.batch = batch
+        width, height = ctypes.c_int(), ctypes.c_int()
+        self._library.chip8_env_frame_size(self._env, ctypes.byref(width), ctypes.byref(height))
+        self.width, self.height = width.value, height.value
+        self.observation_size = self._library.chip8_env_observation_size(self._env)
+
+        self._actions = (ctypes.c_uint16 * batch)()
+        self._observations = (ctypes.c_uint8 * (batch * self.observation_size))()
+        self._rewards_out = (ctypes.c_float * batch)()
+        self._dones = (ctypes.c_uint8 * batch)()
+        if numpy is not None:
+            shape = (batch, self.observation_size // 8) if bit_packed else (batch, self.height, self.width)
+            self.observations = numpy.frombuffer(self._observations, numpy.uint64 if bit_packed else numpy.uint8)
+            self.observations = self.observations.reshape(shape)
+            self.rewards = numpy.frombuffer(self._rewards_out, numpy.float32)
+            self.dones = numpy.frombuffer(self._dones, numpy.bool_)
+        else:
+            self.observations, self.rewards, self.dones = self._observations, self._rewards_out, self._dones
+
+    def __del__(self):
+        if getattr(self, "_env", None):
+            self._library.chip8_env_destroy(self._env)
+            self._env = None
+
+    def reset(self):
+        self._library.chip8_env_reset(self._env, self._observations)
+        return self.observations
+
+    def step(self, actions, n_frames=1):
+        # hand a batch-long contiguous uint16 array straight to C; anything
+        # else, strided views and wrong sizes included, is copied, which
+        # also checks the length
+        if (numpy is not None and isinstance(actions, numpy.ndarray) and actions.dtype == numpy.uint16
+                and actions.flags.c_contiguous and actions.size == self.batch):
+            pointer = actions.ctypes.data
+        else:
+            self._actions[:] = actions
+            pointer = self._actions
+        self._library.chip8_env_step(self._env, pointer, n_frames, self._observations, self._rewards_out,
+                                     self._dones)
+        return self.observations, self.rewards, self.dones
@@ -1,63 +1,82 @@
 #include "Chip8.h"
+#include "Chip8_Hash.h"
 #include "constants.h"
-#include <SFML/Window/Keyboard.hpp>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <ios>
+#include <iterator>
+#include <vector>
 
-Chip8::Chip8() {
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::Chip8_Core() {
     initialize_main_memory();
     clear_frame_buffer();
 
+    memset(registers, 0, sizeof(registers));
+    sound_timer = 0;
+    delay_timer = 0;
     stack_pointer = 0;
+    program_counter = 0x200;
+    index_register = 0;
 }
 
-void Chip8::initialize_main_memory() {
-    for (int i = 0; i < MEMORY_BYTES; i++) {
-        main_memory[i] = 0; 
-    }
-
-    // initialize all of the digit sprites
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::initialize_main_memory() {
+    // memory starts out zeroed, so only the digit sprites need writing
     for (int i = 0; i < PRESET_DIGIT_SPRITES_SIZE; i++) {
-        main_memory[i] = PRESET_DIGIT_SPRITES[i];
+        main_memory.write(i, PRESET_DIGIT_SPRITES[i]);
+    }
+    if constexpr (Platform::SUPER_CHIP) {
+        for (int i = 0; i < PRESET_BIG_DIGIT_SPRITES_SIZE; i++) {
+            main_memory.write(BIG_DIGIT_SPRITES_START + i, PRESET_BIG_DIGIT_SPRITES[i]);
+        }
     }
 }
 
-void Chip8::load_rom_to_memory(std::string rom_file_name) {
-    unsigned char* rom_start_pointer = &main_memory[0x200];
-    
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+bool Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::load_rom_to_memory(std::string rom_file_name) {
     std::ifstream myFile(rom_file_name, std::ios::binary);
-
-    char ch;
-    while (myFile.get(ch)) {
-        *rom_start_pointer = (unsigned char)ch;
-        rom_start_pointer++;
+    if (!myFile) {
+        fprintf(stderr, "[ERROR] Could not open rom %s\n", rom_file_name.c_str());
+        return false;
     }
+    std::vector<unsigned char> rom((std::istreambuf_iterator<char>(myFile)), std::istreambuf_iterator<char>());
+    load_rom(rom.data(), rom.size());
+    return true;
+}
 
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::load_rom(const unsigned char* bytes, size_t size) {
+    patch_rom(bytes, size);
     program_counter = 0x200;
+}
 
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::patch_rom(const unsigned char* bytes, size_t size) {
+    for (size_t i = 0; i < size && 0x200 + i < (size_t)Platform::MEMORY_BYTES; i++) {
+        main_memory.write(0x200 + i, bytes[i]);
+    }
+}
 
-    // for (int i = 0x200; i < 4096; i++) {
-    //     printf("0x%x ", main_memory[i]);
-    //     if (i % 0x100 == 0 && i != 0x200) {
-    //         printf("\n");
-    //         printf("%d: ", i);
-    //     }
-    // }
-
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::clear_frame_buffer() {
+    memset(frame_buffer, 0, sizeof(frame_buffer));
+    frame_hash = 0;
 }
 
-void Chip8::clear_frame_buffer() {
-    for (int r = 0; r < PIXELS_HEIGHT; r++) {
-        for (int c = 0; c < PIXELS_WIDTH; c++) {
-            frame_buffer[r * PIXELS_WIDTH + c] = 0;
-        }
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::rehash_frame() {
+    frame_hash = 0;
+    for (int i = 0; i < Platform::PLANES * PLANE_WORDS; i++) {
+        frame_hash ^= element_hash(i, frame_buffer[i]);
     }
 }
 
-// This happens 1 per second
-void Chip8::update_timers() {
+// This happens once every cycles_per_tick cycles
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::update_timers() {
     if (sound_timer > 0) {
         sound_timer--;
     }
@@ -67,55 +86,74 @@ void Chip8::update_timers() {
     }
 }
 
-unsigned short instruction;
-
-void Chip8::detail_instruction(std::string instruction_description) {
-    const int GAP = 10;
-    if (DEBUG) {
-        printf("0x%x: 0x%x - %s\n", program_counter, instruction, instruction_description.c_str());
-        // print registers
-        printf("Registers:\n");
-        for (int i = 0; i <= 0xFu; i++) {
-            printf("V%x: 0x%x ", i, registers[i]);
-            if (i % 6 == 0) {
-                printf("\n");
-            }
-        }
-        printf("\n");
-        // print index_register
-        printf("Index Register: %x\n", index_register);
-        // print frame_buffer
-        printf("Frame Buffer:\n");
-        for(int r = 0; r < PIXELS_HEIGHT; r++) {
-            for (int c = 0; c < PIXELS_WIDTH; c++) {
-                printf("%d ", frame_buffer[r * PIXELS_WIDTH + c]);
-            }
-            printf("\n");
-        }
-        // print main memory around index register
-        printf("Main memory:\n");
-        printf("0x%x: ", index_register - GAP);
-        for (int i = index_register - GAP; i <= index_register + GAP; i++) {
-            printf("0x%x ", main_memory[i]);
-        }
-        printf("\n\n\n");
+// Advances virtual time by what the instruction costs, ticking the timers
+// for every tick it reaches. Halted and key waiting machines still use up
+// their cycles.
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::complete_one_instruction() {
+    cycles += execute_next_instruction();
+    while (cycles >= next_tick) {
+        next_tick += cycles_per_tick;
+        // the display's share of the frame
+        cycles += Timing::INTERRUPT_CYCLES;
+        Timeline_Scope scope("update_timers");
+        update_timers();
     }
 }
 
-// This happens multiple times per second and it can be controlled by the user
-// for the overall speed of the game
-void Chip8::complete_one_instruction() {
-    if (wait_for_key()) {
-        printf("Waiting for key repeatedly\n");
-        return;
+// Returns the cycles used
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+unsigned int Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::execute_next_instruction() {
+    if (halted || wait_for_key()) {
+        idle_cycles += Timing::IDLE_CYCLES;
+        return Timing::IDLE_CYCLES;
     }
 
     // fetch the instruction
-    instruction = main_memory[program_counter] << 8;
+    unsigned short instruction = main_memory[program_counter] << 8;
     instruction |= main_memory[program_counter + 1];
 
-    // printf("The current instruction is 0x%x at program counter 0x%x\n", instruction, program_counter);
+    unsigned int instruction_cycles = Timing::cycles(instruction, registers);
+    if constexpr (Timing::DISPLAY_WAIT) {
+        // sprites are drawn right after the display interrupt, so DXYN first
+        // idles until the next frame starts
+        if ((instruction & 0xF000u) == 0xD000u) {
+            instruction_cycles += next_tick - cycles;
+        }
+    }
+
+    if constexpr (Trace_Policy::ENABLED) {
+        unsigned short instruction_address = program_counter;
+        unsigned char registers_before[16];
+        memcpy(registers_before, registers, 16);
+
+        execute(instruction);
+
+        trace.record(instruction_address, instruction, index_register, registers_before, registers);
+    } else {
+        execute(instruction);
+    }
+    return instruction_cycles;
+}
+
+// Runs a batch of instructions behind a single virtual call
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::run_instructions(unsigned int count) {
+    for (unsigned int i = 0; i < count; i++) {
+        complete_one_instruction();
+    }
+}
+
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::run_frame() {
+    unsigned long long tick = next_tick;
+    while (cycles < tick) {
+        complete_one_instruction();
+    }
+}
 
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::execute(unsigned short instruction) {
     program_counter += 2;
 
     // decode instruction
@@ -126,271 +164,621 @@ void Chip8::complete_one_instruction() {
     unsigned short NNN = (instruction & 0x0FFFu);
 
     unsigned int in_between = 0;
+    unsigned char source = 0;
+    unsigned char flag = 0;
     switch ((instruction & 0xF000u) >> 12) {
         case 0x0u:
             if(instruction == 0x00E0u) {
                 // clear screen
-                clear_frame_buffer();
+                clear_selected_planes();
                 draw_flag = 1;
-                detail_instruction("Clear Frame");
             } else if (instruction == 0x00EEu) {
                 // return
                 program_counter = pop_stack();
-                detail_instruction("Return");
+            } else if (Platform::SUPER_CHIP && (instruction & 0xFFF0u) == 0x00C0u) {
+                // scroll the display down N pixels
+                scroll_down(N * scroll_scale());
+                draw_flag = 1;
+            } else if (Platform::XO_CHIP && (instruction & 0xFFF0u) == 0x00D0u) {
+                // scroll the display up N pixels
+                scroll_up(N * scroll_scale());
+                draw_flag = 1;
+            } else if (Platform::SUPER_CHIP && instruction == 0x00FBu) {
+                // scroll the display right 4 pixels
+                scroll_right(4 * scroll_scale());
+                draw_flag = 1;
+            } else if (Platform::SUPER_CHIP && instruction == 0x00FCu) {
+                // scroll the display left 4 pixels
+                scroll_left(4 * scroll_scale());
+                draw_flag = 1;
+            } else if (Platform::SUPER_CHIP && instruction == 0x00FDu) {
+                // exit the interpreter
+                halted = true;
+            } else if (Platform::SUPER_CHIP && instruction == 0x00FEu) {
+                // switch to low resolution
+                set_resolution(false);
+            } else if (Platform::SUPER_CHIP && instruction == 0x00FFu) {
+                // switch to high resolution
+                set_resolution(true);
             } else {
-                printf("INVALID INSTRUCTION 0x%x\n", instruction);
+                invalid_instruction(instruction);
             }
             break;
         case 0x1u:
             // jump to NNN
+            if (NNN <= program_counter - 2 && program_counter - 2 - NNN <= IDLE_LOOP_BYTES &&
+                (NNN == program_counter - 2 || ((main_memory[NNN] & 0xF0u) == 0xF0u && main_memory[NNN + 1] == 0x07u))) {
+                // the whole loop counts as idle, at the jump's cost per instruction
+                idle_cycles += Timing::cycles(instruction, registers) * ((program_counter - 2 - NNN) / 2 + 1);
+            }
             program_counter = NNN;
-            detail_instruction("Jump to NNN");
             break;
         case 0x2u:
             push_stack(program_counter);
             program_counter = NNN;
-            detail_instruction("Call Function NNN");
             break;
         case 0x3u:
             // skip next instruction if Vx = NN
             if (registers[X] == NN) {
-                program_counter += 2;
+                skip_instruction();
             }
-            detail_instruction("Skip next instruction if Vx = NN");
             break;
         case 0x4u:
             // skip next instruction if Vx != NN
             if (registers[X] != NN) {
-                program_counter += 2;
+                skip_instruction();
             }
-            detail_instruction("Skip next instruction if Vx != NN");
             break;
         case 0x5u:
-            // skip next instruction if Vx = Vy
-            if (registers[X] == registers[Y]) {
-                program_counter += 2;
+            if (Platform::XO_CHIP && N == 0x2u) {
+                // Store Vx to Vy (in either order) in memory at I
+                for (int i = 0; i <= abs(X - Y); i++) {
+                    main_memory.write(index_register + i, registers[X < Y ? X + i : X - i]);
+                }
+            } else if (Platform::XO_CHIP && N == 0x3u) {
+                // Load Vx to Vy (in either order) from memory at I
+                for (int i = 0; i <= abs(X - Y); i++) {
+                    registers[X < Y ? X + i : X - i] = main_memory[index_register + i];
+                }
+            } else if (registers[X] == registers[Y]) {
+                // skip next instruction if Vx = Vy
+                skip_instruction();
             }
-            detail_instruction("Skip next instruction if Vx = Vy");
             break;
         case 0x6u:
             // set Vx = NN
             registers[X] = NN;
-            detail_instruction("Set Vx to NN");
             break;
         case 0x7u:
             // increment Vx by NN
             registers[X] += NN;
-            detail_instruction("Increment Vx by NN");
             break;
         case 0x8u:
             switch(instruction & 0xFu) {
                 case 0x0u:
                     // Set Vx = Vy
                     registers[X] = registers[Y];
-                    detail_instruction("Set Vx to Vy");
                     break;
                 case 0x1u:
                     // Set Vx = Vy OR Vx
                     registers[X] = registers[X] | registers[Y];
-                    detail_instruction("Set Vx to Vy OR Vx");
+                    if constexpr (Quirks::LOGIC_RESETS_VF) {
+                        registers[0xF] = 0;
+                    }
                     break;
                 case 0x2u:
                     // Set Vx = Vx AND Vy
                     registers[X] = registers[X] & registers[Y];
-                    detail_instruction("Set Vx to Vy AND Vx");
+                    if constexpr (Quirks::LOGIC_RESETS_VF) {
+                        registers[0xF] = 0;
+                    }
                     break;
                 case 0x3u:
                     // Set Vx = Vx XOR Vy
                     registers[X] = registers[X] ^ registers[Y];
-                    detail_instruction("Set Vx to Vy XOR Vx");
+                    if constexpr (Quirks::LOGIC_RESETS_VF) {
+                        registers[0xF] = 0;
+                    }
                     break;
+                // The flag is written after the result, so with X = F the
+                // flag is what VF ends up holding
                 case 0x4u:
                     // Set Vx = Vx + Vy and have VF = carry
                     in_between = (unsigned int)registers[X] + (unsigned int)registers[Y];
                     registers[X] = (unsigned char)(in_between & 0xFFu);
                     registers[0xF] = (unsigned char)((in_between >> 8) > 0);
-                    detail_instruction("Set Vx to Vy + Vx");
                     break;
                 case 0x5u:
-                    // Set Vx = Vx - Vy
-                    registers[0xF] = 1;
-                    if (registers[X] <= registers[Y]) {
-                        registers[0xF] = 0;
-                    }
+                    // Set Vx = Vx - Vy and have VF = not borrow
+                    flag = registers[X] >= registers[Y];
                     registers[X] -= registers[Y];
-                    detail_instruction("Set Vx to Vx - Vy");
+                    registers[0xF] = flag;
                     break;
                 case 0x6u:
-                    // Set Vx = Vx / 2
-                    registers[0xF] = registers[X] % 2;
-                    registers[X] = registers[X] / 2;
-                    detail_instruction("Set Vx to Vx / 2");
+                    // Set Vx = Vx / 2, or Vy / 2 with SHIFT_USES_VY
+                    source = Quirks::SHIFT_USES_VY ? registers[Y] : registers[X];
+                    registers[X] = source / 2;
+                    registers[0xF] = source % 2;
                     break;
                 case 0x7u:
-                    // Set Vx = Vy - Vx
-                    registers[0xF] = 1;
-                    if (registers[Y] <= registers[X]) {
-                        registers[0xF] = 0;
-                    }
-                    registers[Y] -= registers[X];
-                    detail_instruction("Set Vx to Vy - Vx");
+                    // Set Vx = Vy - Vx and have VF = not borrow
+                    flag = registers[Y] >= registers[X];
+                    registers[X] = registers[Y] - registers[X];
+                    registers[0xF] = flag;
                     break;
                 case 0xEu:
-                    // Set Vx = Vx * 2
-                    registers[0xF] = registers[X] >> 7;
-                    registers[X] = registers[X] * 2;
-                    detail_instruction("Set Vx to Vx * 2");
+                    // Set Vx = Vx * 2, or Vy * 2 with SHIFT_USES_VY
+                    source = Quirks::SHIFT_USES_VY ? registers[Y] : registers[X];
+                    registers[X] = source * 2;
+                    registers[0xF] = source >> 7;
                     break;
                 default:
-                    printf("INVALID INSTRUCTION 0x%x\n", instruction);
+                    invalid_instruction(instruction);
                     break;
             }
             break;
         case 0x9u:
             // skip the next instruction if Vx != Vy
             if (registers[X] != registers[Y]) {
-                program_counter += 2;
+                skip_instruction();
             }
-            detail_instruction("Skip next instruction if Vx != Vy");
             break;
         case 0xAu:
             // set I = NNN
             index_register = NNN;
-            detail_instruction("Set index register to NNN");
             break;
         case 0xBu:
-            // jump to NNN + V0
-            program_counter = NNN + registers[0];
-            detail_instruction("Set program counter to NNN + V0(Jump)");
+            if constexpr (Quirks::JUMP_USES_VX) {
+                // jump to XNN + Vx
+                program_counter = NNN + registers[X];
+            } else {
+                // jump to NNN + V0
+                program_counter = NNN + registers[0];
+            }
             break;
         case 0xCu:
             // set Vx = random byte & kk
-            registers[X] = (rand() % 256) & NN;
-            detail_instruction("Set Vx to a random byte AND NN");
+            registers[X] = next_random() & NN;
             break;
         case 0xDu:
             // draw a sprite onto the screen from memory address I at (Vx, Vy)
-            registers[0xF] = 0;
-            for (int r = 0; r < N; r++) {
-                unsigned char sprite = main_memory[index_register + r];
-                for (int c = 0; c < 8; c++) {
-                    unsigned char new_pixel_value = (sprite >> (7 - c)) & 1;
-                    bool* new_pixel_location = &frame_buffer[((registers[Y] + r) % PIXELS_HEIGHT) * PIXELS_WIDTH + ((registers[X] + c) % PIXELS_WIDTH)];
-                    if (*new_pixel_location == 1 && new_pixel_value == 1) {
-                        registers[0xF] = 1;
-                    }
-                    *new_pixel_location ^= new_pixel_value;
-                }
-            }
+            draw_sprite(registers[X], registers[Y], N);
             draw_flag = 1;
-            detail_instruction("Draw a sprite at (Vx, Vy)");
+            sprites_drawn++;
             break;
         case 0xEu:
             if((instruction & 0xFFu) == 0x9Eu) {
                 // Skip next instruction if key at Vx is pressed
-                if (sf::Keyboard::isKeyPressed(CHIP_8_KEYS.at(registers[X]))) {
-                    program_counter += 2;
+                if (is_key_pressed(registers[X])) {
+                    keys_seen[registers[X] & 0xFu]++;
+                    skip_instruction();
                 }
-                detail_instruction("Skip next instruction if key is pressed");
             } else if ((instruction & 0xFFu) == 0xA1u) {
                 // Skip next instruction if key at Vx is not pressed
-                if (!sf::Keyboard::isKeyPressed(CHIP_8_KEYS.at(registers[X]))) {
-                    program_counter += 2;
+                if (!is_key_pressed(registers[X])) {
+                    skip_instruction();
+                } else {
+                    keys_seen[registers[X] & 0xFu]++;
                 }
-                detail_instruction("Skip next instruction if key is not pressed");
             } else {
-                printf("INVALID INSTRUCTION 0x%x\n", instruction);
+                invalid_instruction(instruction);
             }
             break;
         case 0xFu:
             switch(instruction & 0xFFu) {
+                case 0x00u:
+                    if (!Platform::XO_CHIP || X != 0) {
+                        invalid_instruction(instruction);
+                        break;
+                    }
+                    // Set I to the 16 bit address that follows the instruction
+                    index_register = (main_memory[program_counter] << 8) | main_memory[program_counter + 1];
+                    program_counter += 2;
+                    break;
+                case 0x01u:
+                    if (!Platform::XO_CHIP) {
+                        invalid_instruction(instruction);
+                        break;
+                    }
+                    // Select the bitplanes that drawing, clearing and scrolling affect
+                    plane_mask = X & 0x3u;
+                    break;
+                case 0x02u:
+                    if (!Platform::XO_CHIP || X != 0) {
+                        invalid_instruction(instruction);
+                        break;
+                    }
+                    // Load the 16 byte audio pattern from memory at I
+                    for (int i = 0; i < AUDIO_PATTERN_BYTES; i++) {
+                        audio_pattern[i] = main_memory[index_register + i];
+                    }
+                    has_audio_pattern = true;
+                    break;
                 case 0x07u:
                     // Set Vx to the delay timer value
                     registers[X] = delay_timer;
-                    detail_instruction("Set Vx to the delay timer value");
                     break;
                 case 0x0Au:
                     // Wait for a key press and store the resulting key in Vx
                     key_register = X;
-                    detail_instruction("Wait for a key press");
                     break;
                 case 0x15u:
                     // set delay timer to Vx
                     delay_timer = registers[X];
-                    detail_instruction("Set delay timer to Vx");
                     break;
                 case 0x18u:
                     // set sound timer to Vx
                     sound_timer = registers[X];
-                    detail_instruction("Set sound timer to Vx");
                     break;
                 case 0x1Eu:
                     // Set I = I + Vx
                     index_register += registers[X];
-                    detail_instruction("Set index timer to Vx + previous index timer");
                     break;
                 case 0x29u:
-                    // Set I to the location of the digit sprite for Vx
-                    index_register = registers[X] * 5;
-                    detail_instruction("Set index register to the location of digit sprite for Vx");
+                    // Set I to the location of the digit sprite for the low nibble of Vx
+                    index_register = (registers[X] & 0xFu) * 5;
+                    break;
+                case 0x30u:
+                    if (!Platform::SUPER_CHIP) {
+                        invalid_instruction(instruction);
+                        break;
+                    }
+                    // Set I to the location of the big digit sprite for Vx
+                    index_register = BIG_DIGIT_SPRITES_START + (registers[X] & 0xFu) * 10;
+                    break;
+                case 0x3Au:
+                    if (!Platform::XO_CHIP) {
+                        invalid_instruction(instruction);
+                        break;
+                    }
+                    // Set the audio pattern playback pitch to Vx
+                    pitch = registers[X];
                     break;
                 case 0x33u:
                     // Store the BCD representation of Vx in memory I, I + 1, I + 2
-                    main_memory[index_register] = (registers[X] / 100) % 10;
-                    main_memory[index_register + 1] = (registers[X] / 10) % 10;
-                    main_memory[index_register + 2] = registers[X] % 10;
-                    detail_instruction("Store the BCD representation of Vx in memory");
+                    main_memory.write(index_register, (registers[X] / 100) % 10);
+                    main_memory.write(index_register + 1, (registers[X] / 10) % 10);
+                    main_memory.write(index_register + 2, registers[X] % 10);
                     break;
                 case 0x55u:
-                    // Store V0 to Vx in memory addresses I, I + x, and then makes I be I + x + 1
+                    // Store V0 to Vx in memory addresses I, I + x, and then (with
+                    // LOAD_STORE_INCREMENTS_I) makes I be I + x + 1
                     for (int i = 0; i <= X; i++) {
-                        main_memory[index_register + i] = registers[i];
+                        main_memory.write(index_register + i, registers[i]);
+                    }
+                    if constexpr (Quirks::LOAD_STORE_INCREMENTS_I) {
+                        index_register += X + 1;
                     }
-                    index_register += X + 1;
-                    detail_instruction("Store V0 to Vx in memory and update the index register to be the next spot");
                     break;
                 case 0x65u:
-                    // Set V0 to Vx with values in memory addresses I, I + x and then makes I be I + x + 1
+                    // Set V0 to Vx with values in memory addresses I, I + x and then
+                    // (with LOAD_STORE_INCREMENTS_I) makes I be I + x + 1
                     for (int i = 0; i <= X; i++) {
                         registers[i] = main_memory[index_register + i];
                     }
-                    index_register += X + 1;
-                    detail_instruction("Set V0 to Vx with memory at index register");
+                    if constexpr (Quirks::LOAD_STORE_INCREMENTS_I) {
+                        index_register += X + 1;
+                    }
+                    break;
+                case 0x75u:
+                    if (!Platform::SUPER_CHIP) {
+                        invalid_instruction(instruction);
+                        break;
+                    }
+                    // Store V0 to Vx in the RPL user flags
+                    for (int i = 0; i <= X && i < RPL_FLAGS; i++) {
+                        rpl_flags[i] = registers[i];
+                    }
+                    break;
+                case 0x85u:
+                    if (!Platform::SUPER_CHIP) {
+                        invalid_instruction(instruction);
+                        break;
+                    }
+                    // Set V0 to Vx from the RPL user flags
+                    for (int i = 0; i <= X && i < RPL_FLAGS; i++) {
+                        registers[i] = rpl_flags[i];
+                    }
                     break;
                 default:
-                    printf("INVALID INSTRUCTION 0x%x\n", instruction);
+                    invalid_instruction(instruction);
             }
             break;
         default:
-            printf("INVALID INSTRUCTION 0x%x\n", instruction);
+            invalid_instruction(instruction);
             break;
     }
 }
 
-unsigned short Chip8::pop_stack() {
+// Sprites are drawn a whole row at a time: each sprite row is shifted into
+// place and XORed into at most two frame buffer words. On XO-CHIP the sprite
+// is drawn into every selected plane, each plane reading its own copy of the
+// sprite data right after the previous plane's.
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::draw_sprite(unsigned char x, unsigned char y, unsigned short rows) {
+    int scale = hires ? 1 : Platform::LORES_SCALE;
+    int width = Platform::FRAME_WIDTH / scale;
+    int height = Platform::FRAME_HEIGHT / scale;
+
+    // SUPER-CHIP DXY0 draws a 16x16 sprite stored as two bytes per row
+    bool wide = Platform::SUPER_CHIP && rows == 0;
+    if (wide) {
+        rows = 16;
+    }
+
+    x %= width;
+    y %= height;
+    registers[0xF] = 0;
+    unsigned short address = index_register;
+    for (int p = 0; p < Platform::PLANES; p++) {
+        if (!((plane_mask >> p) & 1u)) {
+            continue;
+        }
+        uint64_t* plane = &frame_buffer[p * PLANE_WORDS];
+        for (int r = 0; r < rows; r++) {
+            uint64_t bits;
+            int bits_width;
+            if (wide) {
+                bits = ((uint64_t)main_memory[address + r * 2] << 8) | main_memory[address + r * 2 + 1];
+                bits_width = 16;
+            } else {
+                bits = main_memory[address + r];
+                bits_width = 8;
+            }
+            if (scale == 2) {
+                // double every bit, so low resolution pixels cover 2x2 frame pixels
+                bits = (bits | (bits << 8)) & 0x00FF00FFu;
+                bits = (bits | (bits << 4)) & 0x0F0F0F0Fu;
+                bits = (bits | (bits << 2)) & 0x33333333u;
+                bits = (bits | (bits << 1)) & 0x55555555u;
+                bits |= bits << 1;
+                bits_width *= 2;
+            }
+            bits <<= 64 - bits_width;
+
+            int row = y + r;
+            if (row >= height) {
+                if constexpr (Quirks::CLIP_SPRITES) {
+                    break;
+                }
+                row %= height;
+            }
+            for (int s = 0; s < scale; s++) {
+                uint64_t* frame_row = &plane[(row * scale + s) * FRAME_WORDS];
+                if (xor_row(frame_row, bits, x * scale)) {
+                    registers[0xF] = 1;
+                }
+            }
+        }
+        address += wide ? 32 : rows;
+    }
+}
+
+// XORs the left aligned bits into the frame row starting at pixel x, wrapping
+// around the right edge unless sprites clip. Returns whether any lit pixel was turned off.
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+bool Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::xor_row(uint64_t* row, uint64_t bits, int x) {
+    int word = x / 64;
+    int offset = x % 64;
+    int next = word + 1 == FRAME_WORDS ? 0 : word + 1;
+
+    uint64_t first = bits >> offset;
+    uint64_t spill = offset ? bits << (64 - offset) : 0;
+    if (Quirks::CLIP_SPRITES && next == 0) {
+        spill = 0;
+    }
+    bool collision = (row[word] & first) || (row[next] & spill);
+    xor_frame_word(&row[word], first);
+    xor_frame_word(&row[next], spill);
+    return collision;
+}
+
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::clear_selected_planes() {
+    for (int p = 0; p < Platform::PLANES; p++) {
+        if ((plane_mask >> p) & 1u) {
+            memset(&frame_buffer[p * PLANE_WORDS], 0, PLANE_WORDS * sizeof(uint64_t));
+        }
+    }
+    rehash_frame();
+}
+
+// XO-CHIP clears the display when switching resolution, SUPER-CHIP does not
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::set_resolution(bool high) {
+    hires = high;
+    if constexpr (Platform::XO_CHIP) {
+        clear_frame_buffer();
+        draw_flag = 1;
+    }
+}
+
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::scroll_down(int rows) {
+    if (rows > Platform::FRAME_HEIGHT) {
+        rows = Platform::FRAME_HEIGHT;
+    }
+    for (int p = 0; p < Platform::PLANES; p++) {
+        if (!((plane_mask >> p) & 1u)) {
+            continue;
+        }
+        uint64_t* plane = &frame_buffer[p * PLANE_WORDS];
+        memmove(&plane[rows * FRAME_WORDS], plane, (Platform::FRAME_HEIGHT - rows) * FRAME_WORDS * sizeof(uint64_t));
+        memset(plane, 0, rows * FRAME_WORDS * sizeof(uint64_t));
+    }
+    rehash_frame();
+}
+
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::scroll_up(int rows) {
+    if (rows > Platform::FRAME_HEIGHT) {
+        rows = Platform::FRAME_HEIGHT;
+    }
+    for (int p = 0; p < Platform::PLANES; p++) {
+        if (!((plane_mask >> p) & 1u)) {
+            continue;
+        }
+        uint64_t* plane = &frame_buffer[p * PLANE_WORDS];
+        memmove(plane, &plane[rows * FRAME_WORDS], (Platform::FRAME_HEIGHT - rows) * FRAME_WORDS * sizeof(uint64_t));
+        memset(&plane[(Platform::FRAME_HEIGHT - rows) * FRAME_WORDS], 0, rows * FRAME_WORDS * sizeof(uint64_t));
+    }
+    rehash_frame();
+}
+
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::scroll_right(int pixels) {
+    for (int p = 0; p < Platform::PLANES; p++) {
+        if (!((plane_mask >> p) & 1u)) {
+            continue;
+        }
+        for (int r = 0; r < Platform::FRAME_HEIGHT; r++) {
+            uint64_t* row = &frame_buffer[p * PLANE_WORDS + r * FRAME_WORDS];
+            for (int w = FRAME_WORDS - 1; w > 0; w--) {
+                row[w] = (row[w] >> pixels) | (row[w - 1] << (64 - pixels));
+            }
+            row[0] >>= pixels;
+        }
+    }
+    rehash_frame();
+}
+
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::scroll_left(int pixels) {
+    for (int p = 0; p < Platform::PLANES; p++) {
+        if (!((plane_mask >> p) & 1u)) {
+            continue;
+        }
+        for (int r = 0; r < Platform::FRAME_HEIGHT; r++) {
+            uint64_t* row = &frame_buffer[p * PLANE_WORDS + r * FRAME_WORDS];
+            for (int w = 0; w < FRAME_WORDS - 1; w++) {
+                row[w] = (row[w] << pixels) | (row[w + 1] >> (64 - pixels));
+            }
+            row[FRAME_WORDS - 1] <<= pixels;
+        }
+    }
+    rehash_frame();
+}
+
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+Chip8_Cpu_State Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::get_cpu_state() const {
+    Chip8_Cpu_State state;
+    memcpy(state.registers, registers, sizeof(registers));
+    state.index_register = index_register;
+    state.program_counter = program_counter;
+    state.stack_pointer = stack_pointer;
+    state.delay_timer = delay_timer;
+    state.sound_timer = sound_timer;
+    state.key_register = key_register;
+    state.halted = halted;
+    return state;
+}
+
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+uint64_t Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::hash_state() const {
+    // field by field, since Chip8_Cpu_State has padding
+    Chip8_Cpu_State state = get_cpu_state();
+    uint64_t hash = fnv1a(state.registers, sizeof(state.registers));
+    hash = fnv1a(&state.index_register, sizeof(state.index_register), hash);
+    hash = fnv1a(&state.program_counter, sizeof(state.program_counter), hash);
+    hash = fnv1a(&state.stack_pointer, sizeof(state.stack_pointer), hash);
+    hash = fnv1a(&state.delay_timer, sizeof(state.delay_timer), hash);
+    hash = fnv1a(&state.sound_timer, sizeof(state.sound_timer), hash);
+    hash = fnv1a(&state.key_register, sizeof(state.key_register), hash);
+    hash = fnv1a(&state.halted, sizeof(state.halted), hash);
+    hash = fnv1a(&random_state, sizeof(random_state), hash);
+    hash = fnv1a(stack, stack_pointer, hash);
+    uint64_t memory_hash = main_memory.get_hash();
+    hash = fnv1a(&memory_hash, sizeof(memory_hash), hash);
+    hash = fnv1a(&frame_hash, sizeof(frame_hash), hash);
+    if constexpr (Platform::SUPER_CHIP) {
+        hash = fnv1a(&hires, sizeof(hires), hash);
+        hash = fnv1a(rpl_flags, sizeof(rpl_flags), hash);
+    }
+    if constexpr (Platform::XO_CHIP) {
+        hash = fnv1a(&plane_mask, sizeof(plane_mask), hash);
+        hash = fnv1a(audio_pattern, sizeof(audio_pattern), hash);
+        hash = fnv1a(&has_audio_pattern, sizeof(has_audio_pattern), hash);
+        hash = fnv1a(&pitch, sizeof(pitch), hash);
+    }
+    return hash;
+}
+
+// A ROM that runs into data hits invalid instructions on every step, so
+// only the first one is printed
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::invalid_instruction(unsigned short instruction) {
+    if (invalid_instructions == 0) {
+        fprintf(stderr, "INVALID INSTRUCTION 0x%x at 0x%x, further ones are only counted\n", instruction,
+                program_counter - 2);
+    }
+    invalid_instructions++;
+}
+
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::stop(Chip8_Fault reason) {
+    if (fault == Chip8_Fault::NONE) {
+        fprintf(stderr, "[ERROR] %s at 0x%x, halting\n",
+                reason == Chip8_Fault::STACK_OVERFLOW ? "Stack overflow" : "Stack underflow", program_counter - 2);
+    }
+    fault = reason;
+    halted = true;
+}
+
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+unsigned short Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::pop_stack() {
     if (stack_pointer <= 1) {
-        printf("[ERROR] There is nothing on the stack to pop from");
-        return 0;
+        stop(Chip8_Fault::STACK_UNDERFLOW);
+        return program_counter;
     }
     unsigned short top_stack = ((unsigned short)(stack[stack_pointer - 2]) << 8) + stack[stack_pointer - 1];
     stack_pointer -= 2;
     return top_stack;
 }
 
-void Chip8::push_stack(unsigned short val) {
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+void Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::push_stack(unsigned short val) {
+    if (stack_pointer > STACK_BYTES - 2) {
+        stop(Chip8_Fault::STACK_OVERFLOW);
+        return;
+    }
     stack[stack_pointer] = (unsigned char)((val & 0xFF00) >> 8);
     stack[stack_pointer + 1] = (unsigned char)((val & 0x00FF));
     stack_pointer += 2;
 }
 
-bool Chip8::wait_for_key() {
+template <typename Platform, typename Quirks, typename Timing, typename Trace_Policy>
+bool Chip8_Core<Platform, Quirks, Timing, Trace_Policy>::wait_for_key() {
     if (key_register != (unsigned char)-1) {
         for (unsigned char i = 0x0; i <= 0xF; i++) {
-            if (sf::Keyboard::isKeyPressed(CHIP_8_KEYS.at(i))) {
+            if (is_key_pressed(i)) {
                 registers[key_register] = i;
                 key_register = -1;
+                keys_seen[i]++;
+                break;
             }
         }
     }
     return key_register != (unsigned char)-1;
 }
+
+// every combination make_chip8 can hand out
+template class Chip8_Core<Chip8_Platform, Modern_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Chip8_Platform, Cowgod_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Chip8_Platform, Vip_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Chip8_Platform, Super_Chip_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Chip8_Platform, Xo_Chip_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Super_Chip_Platform, Modern_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Super_Chip_Platform, Cowgod_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Super_Chip_Platform, Vip_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Super_Chip_Platform, Super_Chip_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Super_Chip_Platform, Xo_Chip_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Xo_Chip_Platform, Modern_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Xo_Chip_Platform, Cowgod_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Xo_Chip_Platform, Vip_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Xo_Chip_Platform, Super_Chip_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Xo_Chip_Platform, Xo_Chip_Quirks, Instruction_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Chip8_Platform, Modern_Quirks, Vip_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Chip8_Platform, Cowgod_Quirks, Vip_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Chip8_Platform, Vip_Quirks, Vip_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Chip8_Platform, Super_Chip_Quirks, Vip_Timing, Chip8_Trace_Policy>;
+template class Chip8_Core<Chip8_Platform, Xo_Chip_Quirks, Vip_Timing, Chip8_Trace_Policy>;
@@ -0,0 +1,61 @@
+#include "Chip8_Audio.h"
+#include <cmath>
+
+Beeper::Beeper(unsigned int sample_rate, unsigned int buffered_samples, unsigned int chunk_samples) {
+    this->sample_rate = sample_rate;
+    this->buffered_samples = buffered_samples;
+    this->chunk_samples = chunk_samples;
+    buzzer_step = step_for(BUZZER_HZ);
+    // a pattern period is all 128 bits
+    pattern_step = step_for(4000.0 / 128);
+}
+
+unsigned int Beeper::step_for(double hz) const {
+    return (unsigned int)(hz / sample_rate * 4294967296.0);
+}
+
+void Beeper::fill(bool sound_on, const unsigned char* pattern, unsigned char pitch) {
+    unsigned int queued = ring.size();
+    if (queued >= buffered_samples) {
+        return;
+    }
+    queue(buffered_samples - queued, sound_on, pattern, pitch);
+}
+
+void Beeper::queue(unsigned int count, bool sound_on, const unsigned char* pattern, unsigned char pitch) {
+    short samples[AUDIO_CHUNK_SAMPLES];
+    while (count > 0) {
+        unsigned int n = count < (unsigned int)AUDIO_CHUNK_SAMPLES ? count : AUDIO_CHUNK_SAMPLES;
+        generate(samples, n, sound_on, pattern, pitch);
+        if (ring.push(samples, n) < n) {
+            return;
+        }
+        count -= n;
+    }
+}
+
+void Beeper::read(short* out, unsigned int count) {
+    unsigned int got = ring.pop(out, count);
+    memset(out + got, 0, (count - got) * sizeof(short));
+}
+
+void Beeper::generate(short* out, unsigned int count, bool sound_on, const unsigned char* pattern, unsigned char pitch) {
+    if (pattern != nullptr && pitch != pattern_pitch) {
+        pattern_pitch = pitch;
+        pattern_step = step_for(4000.0 * std::pow(2.0, (pitch - 64) / 48.0) / 128);
+    }
+    unsigned int step = pattern != nullptr ? pattern_step : buzzer_step;
+
+    for (unsigned int i = 0; i < count; i++) {
+        bool high;
+        if (pattern != nullptr) {
+            // the top 7 bits of the phase pick one of the 128 pattern bits
+            unsigned int bit = phase >> 25;
+            high = (pattern[bit >> 3] >> (7 - (bit & 7))) & 1;
+        } else {
+            high = phase < 0x80000000u;
+        }
+        out[i] = !sound_on ? 0 : high ? BUZZER_AMPLITUDE : -BUZZER_AMPLITUDE;
+        phase += step;
+    }
+}
@@ -0,0 +1,23 @@
+#include "Chip8_Audio_Stream.h"
+
+Chip8_Audio_Stream::Chip8_Audio_Stream(Beeper& beeper) : beeper(beeper) {
+    initialize(1, beeper.get_sample_rate());
+#if SFML_VERSION_MAJOR > 2 || (SFML_VERSION_MAJOR == 2 && SFML_VERSION_MINOR >= 6)
+    setProcessingInterval(sf::milliseconds(AUDIO_REFILL_MS));
+#endif
+}
+
+Chip8_Audio_Stream::~Chip8_Audio_Stream() {
+    stop();
+}
+
+bool Chip8_Audio_Stream::onGetData(Chunk& data) {
+    beeper.read(chunk, CHUNK_SAMPLES);
+    data.samples = chunk;
+    data.sampleCount = CHUNK_SAMPLES;
+    // never end the stream, an empty ring just plays silence
+    return true;
+}
+
+void Chip8_Audio_Stream::onSeek(sf::Time) {
+}
@@ -1,14 +1,24 @@
 #include "Chip8_Display.h"
-#include "constants.h"
+#include "Chip8_Timeline.h"
 #include <SFML/Config.hpp>
 #include <SFML/Graphics/RectangleShape.hpp>
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/Graphics/Texture.hpp>
 #include <SFML/System/Vector2.hpp>
+#include <SFML/Window/Event.hpp>
 #include <SFML/Window/Keyboard.hpp>
 
-Chip8_Display::Chip8_Display(Chip8 chip8, int pixel_box_size) {
-    this->chip8 = chip8;
+// RGB for each colour index; indices 2 and 3 only appear with XO-CHIP planes
+static const sf::Uint8 PALETTE[4][3] = {
+    {255, 255, 255},
+    {0, 0, 0},
+    {170, 85, 0},
+    {85, 85, 85},
+};
+
+Chip8_Display::Chip8_Display(Frame_View frame, int pixel_box_size)
+    : beeper(AUDIO_SAMPLE_RATE, Chip8_Audio_Stream::BUFFERED_SAMPLES, Chip8_Audio_Stream::CHUNK_SAMPLES) {
+    this->frame = frame;
     this->pixel_box_size = pixel_box_size;
     this->texture = new sf::Texture();
 
@@ -18,53 +28,42 @@ Chip8_Display::Chip8_Display(Chip8 chip8, int pixel_box_size) {
     texture->setSmooth(false);
     texture->setRepeated(false);
     pixels = new sf::Uint8[height * (width * 4)];
+
+    audio_stream = new Chip8_Audio_Stream(beeper);
+    audio_stream->play();
 }
 
 void Chip8_Display::initialize_window() {
-    width = pixel_box_size * PIXELS_WIDTH;
-    height = pixel_box_size * PIXELS_HEIGHT;
+    width = pixel_box_size * frame.width;
+    height = pixel_box_size * frame.height;
     window = new sf::RenderWindow(sf::VideoMode(width, height), "Chip 8 Emulator");
 }
 
-void Chip8_Display::render(bool frame_buffer[]) {
+void Chip8_Display::render() {
     sf::RectangleShape rect;
 
-    // bool* frame_buffer = chip8.get_frame_buffer();
-    // bool* frame_buffer = chip8.frame_buffer;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::A)) {
-        printf("\n\n\nThis is the frame buffer of the display one: \n");
-        for (int i = 0; i < PIXELS_HEIGHT; i++) {
-            for (int k = 0; k < PIXELS_WIDTH; k++) {
-                printf("%d ", chip8.frame_buffer[i * PIXELS_WIDTH + k]);
-            }
-            printf("\n");
-        }
-        printf("\n\n\n\n");
-    }
-
-    for (int i = 0; i < PIXELS_HEIGHT; i++) {
-        for (int k = 0; k < PIXELS_WIDTH; k++) {
-            bool curr_pixel_val = frame_buffer[i * PIXELS_WIDTH + k];
-            for (int r = 0; r < pixel_box_size; r++) {
-                for (int c = 0; c < pixel_box_size; c++) {
-                    int i_pixels = i * pixel_box_size + r;
-                    int k_pixels = (k * pixel_box_size + c) * 4;
-                    if (!curr_pixel_val) {
-                        pixels[i_pixels * (width * 4) + k_pixels] = 255;
-                        pixels[i_pixels * (width * 4) + k_pixels + 1] = 255;
-                        pixels[i_pixels * (width * 4) + k_pixels + 2] = 255;
-                        pixels[i_pixels * (width * 4) + k_pixels + 3] = 255;
-                    } else {
-                        pixels[i_pixels * (width * 4) + k_pixels] = 0;
-                        pixels[i_pixels * (width * 4) + k_pixels + 1] = 0;
-                        pixels[i_pixels * (width * 4) + k_pixels + 2] = 0;
+    {
+        Timeline_Scope scope("expand_pixels");
+        for (int i = 0; i < frame.height; i++) {
+            for (int k = 0; k < frame.width; k++) {
+                const sf::Uint8* colour = PALETTE[frame.at(k, i)];
+                for (int r = 0; r < pixel_box_size; r++) {
+                    for (int c = 0; c < pixel_box_size; c++) {
+                        int i_pixels = i * pixel_box_size + r;
+                        int k_pixels = (k * pixel_box_size + c) * 4;
+                        pixels[i_pixels * (width * 4) + k_pixels] = colour[0];
+                        pixels[i_pixels * (width * 4) + k_pixels + 1] = colour[1];
+                        pixels[i_pixels * (width * 4) + k_pixels + 2] = colour[2];
                         pixels[i_pixels * (width * 4) + k_pixels + 3] = 255;
                     }
                 }
             }
         }
     }
-    texture->update(pixels);
+    {
+        Timeline_Scope scope("texture_update");
+        texture->update(pixels);
+    }
 
     rect.setPosition(0, 0);
     rect.setSize({(float)width, (float)height});
@@ -72,9 +71,41 @@ void Chip8_Display::render(bool frame_buffer[]) {
 
     window->clear();
     window->draw(rect);
+    Timeline_Scope scope("display");
     window->display();
 }
 
+bool Chip8_Display::is_open() {
+    return window->isOpen();
+}
+
+unsigned short Chip8_Display::poll_input() {
+    sf::Event event;
+    while (window->pollEvent(event)) {
+        if (event.type == sf::Event::Closed) {
+            window->close();
+        } else if (event.type == sf::Event::LostFocus) {
+            keypad = 0;
+        } else if (event.type == sf::Event::KeyPressed || event.type == sf::Event::KeyReleased) {
+            for (auto& key : CHIP_8_KEYS) {
+                if (key.second != event.key.code) {
+                    continue;
+                }
+                if (event.type == sf::Event::KeyPressed) {
+                    keypad |= 1u << key.first;
+                } else {
+                    keypad &= ~(1u << key.first);
+                }
+            }
+        }
+    }
+    return keypad;
+}
+
+void Chip8_Display::set_sound(bool) {
+}
+
 Chip8_Display::~Chip8_Display() {
+    delete audio_stream;
     delete window;
 }
@@ -0,0 +1,183 @@
+#include "Chip8_Env.h"
+#include "Chip8_Factory.h"
+#include "constants.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+struct chip8_env {
+    chip8_env_config config;
+    std::vector<chip8_env_reward> rewards;
+    // the state every episode starts from
+    std::unique_ptr<Chip8_Machine> initial;
+    std::vector<std::unique_ptr<Chip8_Machine>> machines;
+    std::vector<unsigned long long> episode_frames;
+    // each machine's reward values as of its last step, reward_count apiece
+    std::vector<int> values;
+    std::vector<int> initial_values;
+    // the frame before the last one, for max pooling
+    std::vector<uint64_t> pooled;
+    Frame_View geometry;
+    size_t frame_words;
+    size_t observation_size;
+};
+
+static int reward_value(Chip8_Machine& machine, const chip8_env_reward& reward) {
+    int value = machine.read_memory(reward.address);
+    if (reward.size == 2) {
+        value = value << 8 | machine.read_memory(reward.address + 1);
+    }
+    return value;
+}
+
+static void write_observation(chip8_env* env, Chip8_Machine& machine, uint8_t* out) {
+    const uint64_t* rows = machine.get_frame_view().rows;
+    if (env->config.max_pool) {
+        for (size_t k = 0; k < env->frame_words; k++) {
+            env->pooled[k] |= rows[k];
+        }
+        rows = env->pooled.data();
+    }
+    if (env->config.bit_packed) {
+        memcpy(out, rows, env->observation_size);
+        return;
+    }
+
+    // a word at a time, the first plane setting the bytes and the others
+    // adding their bit, which the compiler vectorizes
+    const Frame_View& frame = env->geometry;
+    size_t plane_words = (size_t)frame.height * frame.words_per_row;
+    for (int p = 0; p < frame.planes; p++) {
+        const uint64_t* plane = rows + p * plane_words;
+        for (size_t k = 0; k < plane_words; k++) {
+            uint64_t bits = plane[k];
+            uint8_t* pixels = out + k * 64;
+            if (p == 0) {
+                for (int b = 0; b < 64; b++) {
+                    pixels[b] = (bits >> (63 - b)) & 1u;
+                }
+            } else {
+                for (int b = 0; b < 64; b++) {
+                    pixels[b] |= ((bits >> (63 - b)) & 1u) << p;
+                }
+            }
+        }
+    }
+}
+
+static void reset_machine(chip8_env* env, unsigned int i) {
+    env->machines[i]->restore_state_from(*env->initial);
+    env->episode_frames[i] = 0;
+    std::copy(env->initial_values.begin(), env->initial_values.end(), env->values.begin() + i * env->rewards.size());
+}
+
+static bool is_done(chip8_env* env, unsigned int i) {
+    Chip8_Machine& machine = *env->machines[i];
+    const chip8_env_config& config = env->config;
+    return machine.is_halted() ||
+           (config.done_address >= 0 && machine.read_memory(config.done_address) == config.done_value) ||
+           (config.max_frames != 0 && env->episode_frames[i] >= config.max_frames);
+}
+
+chip8_env* chip8_env_create(const unsigned char* rom, size_t rom_size, unsigned int batch,
+                            const chip8_env_config* config) {
+    Chip8_Variant variant = Chip8_Variant::CHIP_8;
+    if (batch == 0 || (config->variant != nullptr && !parse_variant(config->variant, variant))) {
+        return nullptr;
+    }
+    Chip8_Quirk_Set quirks = default_quirks(variant);
+    if (config->quirks != nullptr && !parse_quirk_set(config->quirks, quirks)) {
+        return nullptr;
+    }
+    for (unsigned int r = 0; r < config->reward_count; r++) {
+        if (config->rewards[r].size != 1 && config->rewards[r].size != 2) {
+            return nullptr;
+        }
+    }
+
+    chip8_env* env = new chip8_env();
+    env->config = *config;
+    env->rewards.assign(config->rewards, config->rewards + config->reward_count);
+    env->config.rewards = env->rewards.data();
+    env->initial = make_chip8(variant, quirks);
+    env->initial->set_cycles_per_tick(config->instructions_per_frame != 0 ? config->instructions_per_frame
+                                                                          : DEFAULT_INSTRUCTIONS_PER_FRAME);
+    env->initial->load_rom(rom, rom_size);
+    for (const chip8_env_reward& reward : env->rewards) {
+        env->initial_values.push_back(reward_value(*env->initial, reward));
+    }
+
+    env->geometry = env->initial->get_frame_view();
+    env->frame_words = (size_t)env->geometry.planes * env->geometry.height * env->geometry.words_per_row;
+    env->observation_size = config->bit_packed ? env->frame_words * sizeof(uint64_t)
+                                               : (size_t)env->geometry.width * env->geometry.height;
+    env->pooled.resize(env->frame_words);
+    env->episode_frames.resize(batch);
+    env->values.resize(batch * env->rewards.size());
+    for (unsigned int i = 0; i < batch; i++) {
+        env->machines.push_back(env->initial->fork());
+        reset_machine(env, i);
+    }
+    return env;
+}
+
+void chip8_env_destroy(chip8_env* env) {
+    delete env;
+}
+
+unsigned int chip8_env_batch(const chip8_env* env) {
+    return (unsigned int)env->machines.size();
+}
+
+size_t chip8_env_observation_size(const chip8_env* env) {
+    return env->observation_size;
+}
+
+void chip8_env_frame_size(const chip8_env* env, int* width, int* height) {
+    *width = env->geometry.width;
+    *height = env->geometry.height;
+}
+
+void chip8_env_reset(chip8_env* env, uint8_t* observations) {
+    for (unsigned int i = 0; i < env->machines.size(); i++) {
+        reset_machine(env, i);
+        // nothing to pool with on the first frame of an episode
+        std::fill(env->pooled.begin(), env->pooled.end(), 0);
+        write_observation(env, *env->machines[i], observations + i * env->observation_size);
+    }
+}
+
+void chip8_env_step(chip8_env* env, const uint16_t* actions, unsigned int n_frames, uint8_t* observations,
+                    float* rewards, uint8_t* dones) {
+    size_t reward_count = env->rewards.size();
+    for (unsigned int i = 0; i < env->machines.size(); i++) {
+        Chip8_Machine& machine = *env->machines[i];
+        machine.set_keypad(actions[i]);
+        std::fill(env->pooled.begin(), env->pooled.end(), 0);
+        bool done = false;
+        for (unsigned int f = 0; f < n_frames && !done; f++) {
+            if (env->config.max_pool) {
+                memcpy(env->pooled.data(), machine.get_frame_view().rows, env->frame_words * sizeof(uint64_t));
+            }
+            machine.run_frame();
+            env->episode_frames[i]++;
+            done = is_done(env, i);
+        }
+
+        float reward = 0;
+        int* values = env->values.data() + i * reward_count;
+        for (size_t r = 0; r < reward_count; r++) {
+            int value = reward_value(machine, env->rewards[r]);
+            reward += env->rewards[r].scale * (float)(value - values[r]);
+            values[r] = value;
+        }
+        rewards[i] = reward;
+        dones[i] = done;
+
+        if (done) {
+            reset_machine(env, i);
+            std::fill(env->pooled.begin(), env->pooled.end(), 0);
+        }
+        write_observation(env, machine, observations + i * env->observation_size);
+    }
+}
@@ -0,0 +1,129 @@
+#include "Chip8_Factory.h"
+#include "Chip8.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+template <typename Platform, typename Timing>
+static std::unique_ptr<Chip8_Machine> make_with_quirks(Chip8_Quirk_Set quirks) {
+    switch (quirks) {
+        case Chip8_Quirk_Set::COWGOD:
+            return std::make_unique<Chip8_Core<Platform, Cowgod_Quirks, Timing, Chip8_Trace_Policy>>();
+        case Chip8_Quirk_Set::VIP:
+            return std::make_unique<Chip8_Core<Platform, Vip_Quirks, Timing, Chip8_Trace_Policy>>();
+        case Chip8_Quirk_Set::SUPER_CHIP:
+            return std::make_unique<Chip8_Core<Platform, Super_Chip_Quirks, Timing, Chip8_Trace_Policy>>();
+        case Chip8_Quirk_Set::XO_CHIP:
+            return std::make_unique<Chip8_Core<Platform, Xo_Chip_Quirks, Timing, Chip8_Trace_Policy>>();
+        case Chip8_Quirk_Set::MODERN:
+        default:
+            return std::make_unique<Chip8_Core<Platform, Modern_Quirks, Timing, Chip8_Trace_Policy>>();
+    }
+}
+
+std::unique_ptr<Chip8_Machine> make_chip8(Chip8_Variant variant, Chip8_Quirk_Set quirks, Chip8_Timing_Model timing) {
+    if (timing == Chip8_Timing_Model::VIP) {
+        if (variant == Chip8_Variant::CHIP_8) {
+            return make_with_quirks<Chip8_Platform, Vip_Timing>(quirks);
+        }
+        fprintf(stderr, "[ERROR] VIP timing is only available for CHIP-8, counting instructions instead\n");
+    }
+    switch (variant) {
+        case Chip8_Variant::SUPER_CHIP:
+            return make_with_quirks<Super_Chip_Platform, Instruction_Timing>(quirks);
+        case Chip8_Variant::XO_CHIP:
+            return make_with_quirks<Xo_Chip_Platform, Instruction_Timing>(quirks);
+        case Chip8_Variant::CHIP_8:
+        default:
+            return make_with_quirks<Chip8_Platform, Instruction_Timing>(quirks);
+    }
+}
+
+Chip8_Quirk_Set default_quirks(Chip8_Variant variant) {
+    switch (variant) {
+        case Chip8_Variant::SUPER_CHIP:
+            return Chip8_Quirk_Set::SUPER_CHIP;
+        case Chip8_Variant::XO_CHIP:
+            return Chip8_Quirk_Set::XO_CHIP;
+        case Chip8_Variant::CHIP_8:
+        default:
+            return Chip8_Quirk_Set::MODERN;
+    }
+}
+
+static bool has_extension(const std::string& name, const char* extension) {
+    size_t length = strlen(extension);
+    return name.size() > length && name.compare(name.size() - length, length, extension) == 0;
+}
+
+Chip8_Variant detect_variant(const std::string& rom_file_name) {
+    if (has_extension(rom_file_name, ".xo8")) {
+        return Chip8_Variant::XO_CHIP;
+    }
+    if (has_extension(rom_file_name, ".sc8")) {
+        return Chip8_Variant::SUPER_CHIP;
+    }
+    if (has_extension(rom_file_name, ".ch8")) {
+        return Chip8_Variant::CHIP_8;
+    }
+
+    // Only look at a few instructions that are unlikely to show up in sprite
+    // data: switching plane or loading audio means XO-CHIP, switching to high
+    // resolution means SUPER-CHIP.
+    std::ifstream file(rom_file_name, std::ios::binary);
+    std::vector<unsigned char> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    bool super_chip = false;
+    for (size_t i = 0; i + 1 < rom.size(); i += 2) {
+        unsigned short instruction = (rom[i] << 8) | rom[i + 1];
+        if (instruction == 0xF002u || instruction == 0xF201u || instruction == 0xF301u) {
+            return Chip8_Variant::XO_CHIP;
+        }
+        if (instruction == 0x00FFu) {
+            super_chip = true;
+        }
+    }
+    return super_chip ? Chip8_Variant::SUPER_CHIP : Chip8_Variant::CHIP_8;
+}
+
+bool parse_variant(const char* name, Chip8_Variant& variant) {
+    if (strcmp(name, "chip8") == 0) {
+        variant = Chip8_Variant::CHIP_8;
+    } else if (strcmp(name, "schip") == 0) {
+        variant = Chip8_Variant::SUPER_CHIP;
+    } else if (strcmp(name, "xochip") == 0) {
+        variant = Chip8_Variant::XO_CHIP;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parse_quirk_set(const char* name, Chip8_Quirk_Set& quirks) {
+    if (strcmp(name, "modern") == 0) {
+        quirks = Chip8_Quirk_Set::MODERN;
+    } else if (strcmp(name, "cowgod") == 0) {
+        quirks = Chip8_Quirk_Set::COWGOD;
+    } else if (strcmp(name, "vip") == 0) {
+        quirks = Chip8_Quirk_Set::VIP;
+    } else if (strcmp(name, "schip") == 0) {
+        quirks = Chip8_Quirk_Set::SUPER_CHIP;
+    } else if (strcmp(name, "xochip") == 0) {
+        quirks = Chip8_Quirk_Set::XO_CHIP;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parse_timing_model(const char* name, Chip8_Timing_Model& timing) {
+    if (strcmp(name, "instructions") == 0) {
+        timing = Chip8_Timing_Model::INSTRUCTIONS;
+    } else if (strcmp(name, "vip") == 0) {
+        timing = Chip8_Timing_Model::VIP;
+    } else {
+        return false;
+    }
+    return true;
+}
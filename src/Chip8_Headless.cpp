@@ -0,0 +1,33 @@
+#include "Chip8_Headless.h"
+
+Chip8_Headless::Chip8_Headless(Frame_View frame, unsigned long long max_frames) {
+    this->frame = frame;
+    this->max_frames = max_frames;
+}
+
+bool Chip8_Headless::is_open() {
+    return max_frames == 0 || frames < max_frames;
+}
+
+void Chip8_Headless::render() {
+}
+
+void Chip8_Headless::submit_frame(const Frame_View&) {
+    frames++;
+}
+
+unsigned short Chip8_Headless::poll_input() {
+    return 0;
+}
+
+void Chip8_Headless::set_sound(bool) {
+}
+
+void Chip8_Headless::print_frame(FILE* out) {
+    for (int i = 0; i < frame.height; i++) {
+        for (int k = 0; k < frame.width; k++) {
+            fputc(".#+%"[frame.at(k, i) & 3u], out);
+        }
+        fputc('\n', out);
+    }
+}
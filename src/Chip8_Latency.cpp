@@ -0,0 +1,81 @@
+#include "Chip8_Latency.h"
+
+void Latency_Histogram::add(double ms) {
+    int bucket = ms < 0 ? 0 : (int)ms;
+    buckets[bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1]++;
+    count++;
+    total_ms += ms;
+    if (ms > max_ms) {
+        max_ms = ms;
+    }
+}
+
+double Latency_Histogram::percentile(double p) const {
+    unsigned long long wanted = (unsigned long long)(count * p / 100.0);
+    unsigned long long seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen > wanted) {
+            return i + 1;
+        }
+    }
+    return LATENCY_BUCKETS;
+}
+
+void Latency_Histogram::print(FILE* out, const char* name) const {
+    if (count == 0) {
+        fprintf(out, "%-20s no samples\n", name);
+        return;
+    }
+    fprintf(out, "%-20s n=%llu mean=%.2fms p50<%.0fms p90<%.0fms p99<%.0fms max=%.2fms\n", name, count,
+            total_ms / count, percentile(50), percentile(90), percentile(99), max_ms);
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        if (buckets[i] != 0) {
+            fprintf(out, "    %3d ms%s %llu\n", i, i == LATENCY_BUCKETS - 1 ? "+" : " ", buckets[i]);
+        }
+    }
+}
+
+double Latency_Monitor::elapsed_ms() const {
+    return std::chrono::duration<double, std::milli>(Clock::now() - arrived).count();
+}
+
+void Latency_Monitor::key_arrived(unsigned short keys) {
+    if (stage != Stage::IDLE && elapsed_ms() < 1000) {
+        return;
+    }
+    stage = Stage::ARRIVED;
+    arrived = Clock::now();
+    pressed = keys;
+}
+
+void Latency_Monitor::machine_ran(const Chip8_Counters& before, const Chip8_Counters& after) {
+    if (stage == Stage::ARRIVED) {
+        for (int key = 0; key < 16; key++) {
+            if (((pressed >> key) & 1u) && after.keys_seen[key] != before.keys_seen[key]) {
+                to_seen.add(elapsed_ms());
+                stage = Stage::SEEN;
+                break;
+            }
+        }
+    }
+    // the key and the sprite may well be in the same run
+    if (stage == Stage::SEEN && after.sprites_drawn != before.sprites_drawn) {
+        to_drawn.add(elapsed_ms());
+        stage = Stage::DRAWN;
+    }
+}
+
+void Latency_Monitor::frame_displayed() {
+    if (stage == Stage::DRAWN) {
+        to_displayed.add(elapsed_ms());
+        stage = Stage::IDLE;
+    }
+}
+
+void Latency_Monitor::print(FILE* out) const {
+    fprintf(out, "Input latency from key event, timed at frame ends so up to a frame high:\n");
+    to_seen.print(out, "  read by the game");
+    to_drawn.print(out, "  next sprite drawn");
+    to_displayed.print(out, "  on screen");
+}
@@ -0,0 +1,70 @@
+#include "Chip8_Profile.h"
+#include "Chip8_Factory.h"
+#include "Chip8_Hash.h"
+#include "constants.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+uint64_t hash_rom(const std::string& rom_file_name) {
+    std::ifstream file(rom_file_name, std::ios::binary);
+    if (!file) {
+        return 0;
+    }
+
+    std::vector<unsigned char> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return fnv1a(rom.data(), rom.size());
+}
+
+bool Rom_Profile_Database::load(const std::string& file_name) {
+    std::ifstream file(file_name);
+    if (!file) {
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        std::string hash, variant, quirks;
+        uint64_t rom_hash;
+        Rom_Profile profile;
+        if (!(fields >> hash >> variant >> quirks >> profile.instructions_per_frame) ||
+            !parse_hash(hash.c_str(), rom_hash) ||
+            !parse_variant(variant.c_str(), profile.variant) ||
+            !parse_quirk_set(quirks.c_str(), profile.quirks) ||
+            profile.instructions_per_frame == 0) {
+            fprintf(stderr, "[ERROR] %s:%d is not a valid profile\n", file_name.c_str(), line_number);
+            continue;
+        }
+        std::getline(fields >> std::ws, profile.name);
+        profiles[rom_hash] = profile;
+    }
+    return true;
+}
+
+const Rom_Profile* Rom_Profile_Database::find(uint64_t hash) const {
+    auto it = profiles.find(hash);
+    return it == profiles.end() ? nullptr : &it->second;
+}
+
+Rom_Profile Rom_Profile_Database::profile_for(const std::string& rom_file_name) const {
+    const Rom_Profile* listed = find(hash_rom(rom_file_name));
+    if (listed != nullptr) {
+        return *listed;
+    }
+
+    Rom_Profile profile;
+    profile.variant = detect_variant(rom_file_name);
+    profile.quirks = default_quirks(profile.variant);
+    profile.instructions_per_frame = DEFAULT_INSTRUCTIONS_PER_FRAME;
+    profile.name = rom_file_name;
+    return profile;
+}
@@ -0,0 +1,138 @@
+#include "Chip8_Reload.h"
+#include "Chip8_Timeline.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+static long long modification_time_ns(const std::string& path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return (long long)info.st_mtimespec.tv_sec * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+    return (long long)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+}
+
+Rom_Reloader::Rom_Reloader(const std::string& path, std::function<std::unique_ptr<Chip8_Machine>()> make_machine,
+                           bool replay, unsigned int checkpoint_frames) {
+    this->path = path;
+    this->make_machine = make_machine;
+    this->replay = replay;
+    this->checkpoint_frames = checkpoint_frames;
+    modified_ns = modification_time_ns(path);
+
+#ifdef __linux__
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+    file_name = slash == std::string::npos ? path : path.substr(slash + 1);
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd >= 0 && inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(inotify_fd);
+        inotify_fd = -1;
+    }
+    if (inotify_fd < 0) {
+        fprintf(stderr, "[WARNING] Could not watch %s with inotify, checking its time instead\n", directory.c_str());
+    }
+#endif
+}
+
+Rom_Reloader::~Rom_Reloader() {
+#ifdef __linux__
+    if (inotify_fd >= 0) {
+        close(inotify_fd);
+    }
+#endif
+}
+
+void Rom_Reloader::record_frame(Chip8_Machine& chip8) {
+    if (!replay) {
+        return;
+    }
+    if (frames.size() >= checkpoint_frames) {
+        checkpoint = chip8.fork();
+        frames.clear();
+    }
+    frames.push_back({chip8.get_keypad(), chip8.get_cycles_per_tick()});
+}
+
+bool Rom_Reloader::has_changed() {
+#ifdef __linux__
+    if (inotify_fd >= 0) {
+        // drain every queued event; one save can raise several
+        alignas(struct inotify_event) char buffer[4096];
+        bool changed = false;
+        ssize_t length;
+        while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+            for (ssize_t offset = 0; offset < length;) {
+                const struct inotify_event* event = (const struct inotify_event*)(buffer + offset);
+                if (event->len > 0 && file_name == event->name) {
+                    changed = true;
+                }
+                offset += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        return changed;
+    }
+#endif
+    long long modified = modification_time_ns(path);
+    if (modified == modified_ns) {
+        return false;
+    }
+    modified_ns = modified;
+    return true;
+}
+
+bool Rom_Reloader::reload_if_changed(Chip8_Machine& chip8) {
+    if (!has_changed()) {
+        return false;
+    }
+    Timeline_Scope scope("reload");
+    auto start = std::chrono::steady_clock::now();
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "[ERROR] Could not open rom %s, keeping the running one\n", path.c_str());
+        return false;
+    }
+    std::vector<unsigned char> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    // an assembler that truncates and rewrites in place is caught again on
+    // its final write
+    if (rom.empty()) {
+        return false;
+    }
+
+    std::unique_ptr<Chip8_Machine> fresh;
+    if (checkpoint != nullptr) {
+        fresh = checkpoint->fork();
+        fresh->patch_rom(rom.data(), rom.size());
+    } else {
+        fresh = make_machine();
+        fresh->load_rom(rom.data(), rom.size());
+    }
+    for (const Recorded_Frame& frame : frames) {
+        fresh->set_keypad(frame.keys);
+        fresh->set_cycles_per_tick(frame.cycles_per_tick);
+        fresh->run_frame();
+    }
+    fresh->set_keypad(chip8.get_keypad());
+    fresh->set_cycles_per_tick(chip8.get_cycles_per_tick());
+    chip8.copy_state_from(*fresh);
+    chip8.draw_flag = true;
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (replay) {
+        fprintf(stderr, "Reloaded %s and replayed %zu frames in %.1f ms\n", path.c_str(), frames.size(), ms);
+    } else {
+        fprintf(stderr, "Reloaded %s in %.1f ms\n", path.c_str(), ms);
+    }
+    return true;
+}
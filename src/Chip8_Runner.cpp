@@ -0,0 +1,274 @@
+#include "Chip8_Runner.h"
+#include "Chip8_Timeline.h"
+#include "constants.h"
+#include <chrono>
+#include <thread>
+
+// State shared by the loops below
+struct Run_State {
+    const Run_Options& options;
+    const std::vector<Frame_Sink*>& sinks;
+    // the machine the real state is kept in while running ahead
+    std::unique_ptr<Chip8_Machine> saved;
+    bool sound_on = false;
+
+    unsigned long long frames = 0;
+    // cycles and idle cycles of the frames since the last decision
+    unsigned long long window_cycles = 0;
+    unsigned long long window_idle = 0;
+    double idle_fraction = 0;
+    bool has_idled = false;
+    unsigned int min_cycles_per_tick;
+    unsigned int max_cycles_per_tick;
+
+    Run_State(Chip8_Machine& chip8, const Run_Options& options, const std::vector<Frame_Sink*>& sinks)
+        : options(options), sinks(sinks) {
+        unsigned int cycles_per_tick = chip8.get_cycles_per_tick();
+        min_cycles_per_tick = options.min_cycles_per_tick != 0 ? options.min_cycles_per_tick
+                                                               : (cycles_per_tick / 4 > 1 ? cycles_per_tick / 4 : 1);
+        max_cycles_per_tick = options.max_cycles_per_tick != 0 ? options.max_cycles_per_tick : cycles_per_tick * 2;
+        if (options.run_ahead > 0) {
+            saved = chip8.fork();
+        }
+    }
+};
+
+void Run_Stats::print(FILE* out) const {
+    fprintf(out, "%llu frames, %u cycles per tick, %.0f%% idle\n", frames, cycles_per_tick, idle_fraction * 100);
+    if (audio_synced) {
+        fprintf(out, "audio rate control at %+.0f ppm\n", audio_rate_ppm);
+    }
+    for (const std::pair<unsigned long long, unsigned int>& change : history) {
+        fprintf(out, "    frame %llu: %u cycles per tick\n", change.first, change.second);
+    }
+}
+
+// Every ADAPTIVE_SETTLE_FRAMES frames, measures the share of cycles spent
+// idle and, in adaptive mode, moves cycles per tick by about 10% towards
+// whatever keeps that share between ADAPTIVE_IDLE_LOW and ADAPTIVE_IDLE_HIGH.
+// Games idle in bursts, so single frames say little.
+static void tune(Chip8_Machine& chip8, Run_State& state, const Chip8_Counters& before,
+                 const Chip8_Counters& after) {
+    state.window_cycles += after.cycles - before.cycles;
+    state.window_idle += after.idle_cycles - before.idle_cycles;
+    state.frames++;
+    if (state.options.stats != nullptr) {
+        state.options.stats->frames = state.frames;
+    }
+
+    unsigned int cycles_per_tick = chip8.get_cycles_per_tick();
+    if (state.frames % ADAPTIVE_SETTLE_FRAMES != 0) {
+        return;
+    }
+    state.idle_fraction = state.window_cycles == 0 ? 0 : (double)state.window_idle / state.window_cycles;
+    state.has_idled |= state.window_idle != 0;
+    state.window_cycles = 0;
+    state.window_idle = 0;
+
+    if (state.options.adaptive) {
+        unsigned int step = cycles_per_tick / 10 > 1 ? cycles_per_tick / 10 : 1;
+        unsigned int tuned = cycles_per_tick;
+        if (state.idle_fraction > ADAPTIVE_IDLE_HIGH) {
+            tuned = cycles_per_tick > state.min_cycles_per_tick + step ? cycles_per_tick - step : state.min_cycles_per_tick;
+        } else if (state.idle_fraction < ADAPTIVE_IDLE_LOW && state.has_idled) {
+            tuned = cycles_per_tick + step < state.max_cycles_per_tick ? cycles_per_tick + step : state.max_cycles_per_tick;
+        }
+        if (tuned != cycles_per_tick) {
+            chip8.set_cycles_per_tick(tuned);
+            cycles_per_tick = tuned;
+            if (state.options.stats != nullptr) {
+                std::deque<std::pair<unsigned long long, unsigned int>>& history = state.options.stats->history;
+                history.emplace_back(state.frames, tuned);
+                if (history.size() > (size_t)RUN_STATS_HISTORY) {
+                    history.pop_front();
+                }
+            }
+        }
+    }
+
+    if (state.options.stats != nullptr) {
+        state.options.stats->cycles_per_tick = cycles_per_tick;
+        state.options.stats->idle_fraction = state.idle_fraction;
+    }
+}
+
+static void present(Chip8_Backend& backend, Run_State& state) {
+    {
+        Timeline_Scope scope("render");
+        backend.render();
+    }
+    if (state.options.latency != nullptr) {
+        state.options.latency->frame_displayed();
+    }
+}
+
+// input, display and the sound flag, done on every pass of either loop
+static void service_backend(Chip8_Machine& chip8, Chip8_Backend& backend, Run_State& state) {
+    if (state.options.reloader != nullptr) {
+        state.options.reloader->reload_if_changed(chip8);
+    }
+    unsigned short keys;
+    {
+        Timeline_Scope scope("poll_input");
+        keys = backend.poll_input();
+    }
+    if (state.options.shared != nullptr) {
+        keys |= state.options.shared->get_keypad();
+    }
+    if (state.options.latency != nullptr && (keys & ~chip8.get_keypad()) != 0) {
+        state.options.latency->key_arrived(keys & ~chip8.get_keypad());
+    }
+    chip8.set_keypad(keys);
+
+    if (chip8.draw_flag) {
+        present(backend, state);
+        chip8.draw_flag = false;
+    }
+    if (chip8.is_sound_on() != state.sound_on) {
+        state.sound_on = chip8.is_sound_on();
+        backend.set_sound(state.sound_on);
+    }
+}
+
+// hands the frame to the sinks and the shared memory export
+static void publish(Chip8_Machine& chip8, Run_State& state) {
+    Frame_View frame = chip8.get_frame_view();
+    for (Frame_Sink* sink : state.sinks) {
+        sink->submit_frame(frame);
+    }
+    if (state.options.shared != nullptr) {
+        state.options.shared->publish(frame);
+    }
+}
+
+static void run_one_frame(Chip8_Machine& chip8, Chip8_Backend& backend, Run_State& state) {
+    if (state.options.reloader != nullptr) {
+        state.options.reloader->record_frame(chip8);
+    }
+    Chip8_Counters before = chip8.get_counters();
+    {
+        Timeline_Scope scope("run_frame");
+        chip8.run_frame();
+    }
+    if (state.options.adaptive || state.options.stats != nullptr) {
+        tune(chip8, state, before, chip8.get_counters());
+    }
+    if (state.options.run_ahead == 0) {
+        if (state.options.latency != nullptr) {
+            state.options.latency->machine_ran(before, chip8.get_counters());
+        }
+        publish(chip8, state);
+        return;
+    }
+
+    state.saved->copy_state_from(chip8);
+    {
+        Timeline_Scope scope("run_ahead");
+        for (unsigned int i = 0; i < state.options.run_ahead; i++) {
+            chip8.run_frame();
+        }
+    }
+    if (state.options.latency != nullptr) {
+        state.options.latency->machine_ran(before, chip8.get_counters());
+    }
+    // the frame buffer only holds the future frame until the restore below,
+    // so show it now rather than on the next pass
+    present(backend, state);
+    publish(chip8, state);
+    chip8.copy_state_from(*state.saved);
+    chip8.draw_flag = false;
+}
+
+static void run_clocked(Chip8_Machine& chip8, Chip8_Backend& backend, Run_State& state) {
+    const auto frame_time = std::chrono::microseconds(1000000 / TIMER_HZ);
+    auto next_frame = std::chrono::steady_clock::now();
+    bool throttled = state.options.sync != Sync_Mode::UNTHROTTLED;
+
+    Beeper* beeper = backend.get_beeper();
+    while (backend.is_open()) {
+        service_backend(chip8, backend, state);
+        if (beeper != nullptr) {
+            beeper->fill(chip8.is_sound_on(), chip8.get_audio_pattern(), chip8.get_pitch());
+        }
+
+        if (throttled) {
+            auto now = std::chrono::steady_clock::now();
+            if (now < next_frame) {
+                // short sleeps so input and the beeper keep being serviced
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            next_frame += frame_time;
+            // after a stall, carry on from now instead of racing to catch up
+            if (next_frame < now) {
+                next_frame = now;
+            }
+        }
+        run_one_frame(chip8, backend, state);
+    }
+}
+
+static void run_audio_synced(Chip8_Machine& chip8, Chip8_Backend& backend, Beeper& beeper, Run_State& state) {
+    double samples_per_frame = (double)beeper.get_sample_rate() / TIMER_HZ;
+    unsigned int buffered = beeper.get_buffered_samples();
+    // where the queue should be when frames start, and how far off it was
+    // lately, in half chunks
+    double half_chunk = beeper.get_chunk_samples() / 2.0;
+    double target = buffered - half_chunk;
+    double deviation = 0;
+    if (state.options.stats != nullptr) {
+        state.options.stats->audio_synced = true;
+    }
+    // fraction of a sample carried over to the next frame
+    double owed_samples = 0;
+    // the last frame's samples not queued yet; they go in as the queue
+    // drains, so it never holds more than buffered and a frame's sound
+    // reaches the speaker no later than in wall clock mode
+    unsigned int pending = 0;
+
+    while (backend.is_open()) {
+        service_backend(chip8, backend, state);
+
+        unsigned int queued = beeper.get_queued();
+        if (pending == 0) {
+            if (queued >= buffered) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            run_one_frame(chip8, backend, state);
+
+            // dynamic rate control: a queue that has lately been below the
+            // target makes this frame produce a little more, one above it a
+            // little less
+            deviation += ((target - queued) / half_chunk - deviation) / AUDIO_RATE_SMOOTHING;
+            deviation = deviation > 1.0 ? 1.0 : deviation < -1.0 ? -1.0 : deviation;
+            owed_samples += samples_per_frame * (1.0 + AUDIO_RATE_CONTROL * deviation);
+            if (state.options.stats != nullptr) {
+                state.options.stats->audio_rate_ppm = AUDIO_RATE_CONTROL * deviation * 1e6;
+            }
+            pending = (unsigned int)owed_samples;
+            owed_samples -= pending;
+        }
+
+        unsigned int count = queued < buffered ? buffered - queued : 0;
+        count = count < pending ? count : pending;
+        beeper.queue(count, chip8.is_sound_on(), chip8.get_audio_pattern(), chip8.get_pitch());
+        pending -= count;
+        if (pending > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+void run_emulator(Chip8_Machine& chip8, Chip8_Backend& backend, const std::vector<Frame_Sink*>& sinks,
+                  const Run_Options& options) {
+    Run_State state(chip8, options, sinks);
+
+    Beeper* beeper = backend.get_beeper();
+    if (options.sync == Sync_Mode::AUDIO && beeper != nullptr) {
+        run_audio_synced(chip8, backend, *beeper, state);
+    } else {
+        run_clocked(chip8, backend, state);
+    }
+}
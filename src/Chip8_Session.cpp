@@ -0,0 +1,136 @@
+#include "Chip8_Session.h"
+#include "Chip8_Factory.h"
+#include "Chip8_Profile.h"
+#include "Chip8_Timeline.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// False unless the whole of text is a decimal number from min to max
+static bool parse_number(const char* text, long min, long max, unsigned int& value) {
+    char* end;
+    errno = 0;
+    long number = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno != 0 || number < min || number > max) {
+        return false;
+    }
+    value = (unsigned int)number;
+    return true;
+}
+
+bool Session_Options::parse(int argc, char** argv, int& i) {
+    if (strcmp(argv[i], "--profiles") == 0 && i + 1 < argc) {
+        profiles_file = argv[++i];
+    } else if (strcmp(argv[i], "--ipf") == 0 && i + 1 < argc &&
+               parse_number(argv[i + 1], 1, MAX_INSTRUCTIONS_PER_FRAME, instructions_per_frame)) {
+        i++;
+    } else if (strcmp(argv[i], "--adaptive") == 0) {
+        run.adaptive = true;
+    } else if (strcmp(argv[i], "--ipf-min") == 0 && i + 1 < argc &&
+               parse_number(argv[i + 1], 1, MAX_INSTRUCTIONS_PER_FRAME, run.min_cycles_per_tick)) {
+        i++;
+    } else if (strcmp(argv[i], "--ipf-max") == 0 && i + 1 < argc &&
+               parse_number(argv[i + 1], 1, MAX_INSTRUCTIONS_PER_FRAME, run.max_cycles_per_tick)) {
+        i++;
+    } else if (strcmp(argv[i], "--stats") == 0) {
+        print_stats = true;
+    } else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+        shared_name = argv[++i];
+    } else if (strcmp(argv[i], "--timeline") == 0 && i + 1 < argc) {
+        timeline_file = argv[++i];
+    } else if (strcmp(argv[i], "--run-ahead") == 0 && i + 1 < argc &&
+               parse_number(argv[i + 1], 0, MAX_RUN_AHEAD, run.run_ahead)) {
+        i++;
+    } else if (strcmp(argv[i], "--watch") == 0) {
+        watch = true;
+    } else if (strcmp(argv[i], "--watch-replay") == 0) {
+        watch = true;
+        watch_replay = true;
+    } else if (strcmp(argv[i], "--timing") == 0 && i + 1 < argc && parse_timing_model(argv[i + 1], timing)) {
+        i++;
+    } else if (strcmp(argv[i], "--variant") == 0 && i + 1 < argc && parse_variant(argv[i + 1], variant)) {
+        variant_given = true;
+        i++;
+    } else if (strcmp(argv[i], "--quirks") == 0 && i + 1 < argc && parse_quirk_set(argv[i + 1], quirks)) {
+        quirks_given = true;
+        i++;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool Session::start() {
+    // the ROM's profile, with anything given on the command line on top
+    Rom_Profile_Database profiles;
+    profiles.load(options.profiles_file);
+    Rom_Profile profile = profiles.profile_for(options.rom);
+    if (options.variant_given) {
+        profile.variant = options.variant;
+        profile.quirks = default_quirks(options.variant);
+    }
+    if (options.quirks_given) {
+        profile.quirks = options.quirks;
+    }
+    if (options.instructions_per_frame != 0) {
+        profile.instructions_per_frame = options.instructions_per_frame;
+    }
+
+    if (options.run.min_cycles_per_tick != 0 && options.run.max_cycles_per_tick != 0 &&
+        options.run.min_cycles_per_tick > options.run.max_cycles_per_tick) {
+        fprintf(stderr, "[ERROR] --ipf-min is above --ipf-max\n");
+        return false;
+    }
+
+    Chip8_Timing_Model timing = options.timing;
+    chip8 = make_chip8(profile.variant, profile.quirks, timing);
+    // VIP timing has its own fixed cycle budget per frame
+    if (timing == Chip8_Timing_Model::INSTRUCTIONS) {
+        chip8->set_cycles_per_tick(profile.instructions_per_frame);
+    } else if (options.run.adaptive) {
+        fprintf(stderr, "[ERROR] --adaptive needs instruction timing\n");
+        options.run.adaptive = false;
+    }
+    if (!chip8->load_rom_to_memory(options.rom)) {
+        return false;
+    }
+
+#ifdef CHIP8_TRACE
+    // inspect the resulting file with the chip8-trace tool
+    if (getenv("CHIP8_TRACE_FILE") != nullptr) {
+        chip8->get_trace().open_file(getenv("CHIP8_TRACE_FILE"));
+    }
+#endif
+
+    if (options.print_stats) {
+        options.run.stats = &stats;
+    }
+    if (options.watch) {
+        unsigned int cycles_per_tick = chip8->get_cycles_per_tick();
+        auto make_machine = [profile, timing, cycles_per_tick]() {
+            std::unique_ptr<Chip8_Machine> machine = make_chip8(profile.variant, profile.quirks, timing);
+            machine->set_cycles_per_tick(cycles_per_tick);
+            return machine;
+        };
+        reloader = std::make_unique<Rom_Reloader>(options.rom, make_machine, options.watch_replay);
+        options.run.reloader = reloader.get();
+    }
+    if (options.shared_name != nullptr) {
+        shared = std::make_unique<Shared_Frame_Export>(options.shared_name, chip8->get_frame_view());
+        if (!shared->is_open()) {
+            return false;
+        }
+        options.run.shared = shared.get();
+    }
+    if (options.timeline_file != nullptr) {
+        Timeline::start();
+    }
+    return true;
+}
+
+void Session::finish() {
+    if (options.timeline_file != nullptr) {
+        Timeline::write(options.timeline_file);
+    }
+}
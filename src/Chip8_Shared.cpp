@@ -0,0 +1,65 @@
+#include "Chip8_Shared.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static_assert(sizeof(std::atomic<uint32_t>) == 4 && std::atomic<uint32_t>::is_always_lock_free,
+              "readers in other processes see sequence and keypad as plain uint32s");
+static_assert(offsetof(Shared_Frame_Header, frame) == 16 && sizeof(Shared_Frame_Header) <= SHARED_FRAME_ROWS_OFFSET,
+              "the documented layout");
+
+Shared_Frame_Export::Shared_Frame_Export(const std::string& name, const Frame_View& frame) {
+    this->name = name[0] == '/' ? name : "/" + name;
+    row_words = (size_t)frame.planes * frame.height * frame.words_per_row;
+    size = SHARED_FRAME_ROWS_OFFSET + row_words * sizeof(uint64_t);
+
+    // only processes of the same user may read the screen or press keys
+    int fd = shm_open(this->name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "[ERROR] Could not create shared memory %s\n", this->name.c_str());
+        return;
+    }
+    void* memory = ftruncate(fd, size) == 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                                            : MAP_FAILED;
+    close(fd);
+    if (memory == MAP_FAILED) {
+        fprintf(stderr, "[ERROR] Could not map shared memory %s\n", this->name.c_str());
+        shm_unlink(this->name.c_str());
+        return;
+    }
+
+    // the fresh segment is zeroed, so sequence and keypad start at 0
+    header = new (memory) Shared_Frame_Header();
+    header->width = frame.width;
+    header->height = frame.height;
+    header->words_per_row = frame.words_per_row;
+    header->planes = frame.planes;
+    header->version = SHARED_FRAME_VERSION;
+    rows = (uint64_t*)((unsigned char*)memory + SHARED_FRAME_ROWS_OFFSET);
+    memcpy(rows, frame.rows, row_words * sizeof(uint64_t));
+    // the magic goes in last, so readers that find it see the rest too
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SHARED_FRAME_MAGIC;
+}
+
+Shared_Frame_Export::~Shared_Frame_Export() {
+    if (header != nullptr) {
+        munmap(header, size);
+        shm_unlink(name.c_str());
+    }
+}
+
+void Shared_Frame_Export::publish(const Frame_View& frame) {
+    if (header == nullptr) {
+        return;
+    }
+    uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(rows, frame.rows, row_words * sizeof(uint64_t));
+    header->frame++;
+    header->sequence.store(sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,74 @@
+#include "Chip8_Timeline.h"
+#include "constants.h"
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct Timeline_Event {
+    const char* name;
+    long long start_ns;
+    long long end_ns;
+};
+
+// Buffers are owned here rather than by their threads so events survive
+// threads that exit before the timeline is written
+struct Thread_Buffer {
+    unsigned int thread_id;
+    std::vector<Timeline_Event> events;
+    unsigned long long dropped = 0;
+};
+
+std::atomic<bool> Timeline::enabled{false};
+
+static long long epoch_ns = 0;
+static std::mutex buffers_mutex;
+static std::vector<std::unique_ptr<Thread_Buffer>> buffers;
+static thread_local Thread_Buffer* thread_buffer = nullptr;
+
+void Timeline::start() {
+    epoch_ns = now_ns();
+    enabled = true;
+}
+
+void Timeline::record(const char* name, long long start_ns, long long end_ns) {
+    if (thread_buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        buffers.push_back(std::make_unique<Thread_Buffer>());
+        thread_buffer = buffers.back().get();
+        thread_buffer->thread_id = (unsigned int)buffers.size();
+        thread_buffer->events.reserve(TIMELINE_EVENTS_PER_THREAD);
+    }
+    if (thread_buffer->events.size() == (size_t)TIMELINE_EVENTS_PER_THREAD) {
+        thread_buffer->dropped++;
+        return;
+    }
+    thread_buffer->events.push_back({name, start_ns, end_ns});
+}
+
+bool Timeline::write(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) {
+        fprintf(stderr, "[ERROR] Could not open %s\n", path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+    for (const std::unique_ptr<Thread_Buffer>& buffer : buffers) {
+        for (const Timeline_Event& event : buffer->events) {
+            fprintf(file, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                    first ? "" : ",\n", event.name, buffer->thread_id,
+                    (event.start_ns - epoch_ns) / 1000.0, (event.end_ns - event.start_ns) / 1000.0);
+            first = false;
+        }
+        if (buffer->dropped != 0) {
+            fprintf(stderr, "[ERROR] Timeline buffer of thread %u was full, %llu events dropped\n",
+                   buffer->thread_id, buffer->dropped);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,63 @@
+#include "Chip8_Trace.h"
+#include <unistd.h>
+
+Ring_Buffer_Trace::~Ring_Buffer_Trace() {
+    close_file();
+}
+
+bool Ring_Buffer_Trace::open_file(const char* path) {
+    close_file();
+    file = fopen(path, "wb");
+    if (file == nullptr) {
+        fprintf(stderr, "[ERROR] Could not open trace file %s\n", path);
+        return false;
+    }
+
+    Trace_File_Header header;
+    memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_FILE_VERSION;
+    header.record_size = sizeof(Trace_Record);
+    fwrite(&header, sizeof(header), 1, file);
+
+    // records already in the buffer belong to the time before the file existed
+    file_start = total;
+    flushed = total;
+    return true;
+}
+
+void Ring_Buffer_Trace::flush_file() {
+    // everything recorded since the last flush is still in the buffer, since
+    // flushes happen at least once per CAPACITY records
+    while (flushed < total) {
+        unsigned int start = flushed & (CAPACITY - 1);
+        unsigned long long count = total - flushed;
+        if (count > CAPACITY - start) {
+            count = CAPACITY - start;
+        }
+        fwrite(&records[start], sizeof(Trace_Record), count, file);
+        flushed += count;
+    }
+}
+
+void Ring_Buffer_Trace::rewind_file() {
+    // a state from before the file was opened leaves nothing in it
+    if (total < file_start) {
+        file_start = total;
+    }
+    flushed = total;
+    long size = (long)(sizeof(Trace_File_Header) + (flushed - file_start) * sizeof(Trace_Record));
+    fflush(file);
+    if (ftruncate(fileno(file), size) != 0) {
+        fprintf(stderr, "[WARNING] Could not cut the trace file back to the restored state\n");
+    }
+    fseek(file, size, SEEK_SET);
+}
+
+void Ring_Buffer_Trace::close_file() {
+    if (file == nullptr) {
+        return;
+    }
+    flush_file();
+    fclose(file);
+    file = nullptr;
+}
@@ -0,0 +1,212 @@
+#include "Chip8_Video.h"
+#include "Chip8_Timeline.h"
+#include "constants.h"
+#include <cstring>
+
+Video_Exporter::Video_Exporter(const Video_Options& options, int width, int height) {
+    this->options = options;
+    this->width = width;
+    this->height = height;
+
+    if (this->options.scale < 1) {
+        this->options.scale = 1;
+    }
+    if (this->options.queue_frames < 1) {
+        this->options.queue_frames = 1;
+    }
+    slots.assign(this->options.queue_frames, std::vector<unsigned char>(width * height));
+    slot_numbers.assign(this->options.queue_frames, 0);
+    scaled.resize(width * this->options.scale * height * this->options.scale);
+
+    if (options.format != Video_Format::NONE) {
+        stream = options.path == "-" ? stdout : fopen(options.path.c_str(), "wb");
+        if (stream == nullptr) {
+            fprintf(stderr, "[ERROR] Could not open video output %s\n", options.path.c_str());
+        } else if (options.format == Video_Format::Y4M) {
+            fprintf(stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n",
+                    width * this->options.scale, height * this->options.scale, TIMER_HZ);
+        }
+    }
+
+    encoder = std::thread(&Video_Exporter::encode_loop, this);
+}
+
+Video_Exporter::~Video_Exporter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready.notify_one();
+    encoder.join();
+
+    if (stream != nullptr && stream != stdout) {
+        fclose(stream);
+    } else if (stream != nullptr) {
+        fflush(stream);
+    }
+    if (dropped > 0) {
+        fprintf(stderr, "[WARNING] Video encoder fell behind and dropped %llu of %llu frames\n", dropped, submitted);
+    }
+}
+
+void Video_Exporter::submit_frame(const Frame_View& frame) {
+    std::unique_lock<std::mutex> lock(mutex);
+    unsigned long long number = submitted++;
+    if (!options.drop_when_full) {
+        space.wait(lock, [this] { return count < slots.size(); });
+    }
+    if (count == slots.size()) {
+        dropped++;
+        return;
+    }
+
+    // the encoder never touches slots past head + count, so this copy is safe
+    // while it works on older frames
+    unsigned int slot = (head + count) % slots.size();
+    unsigned char* pixels = slots[slot].data();
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            pixels[y * width + x] = frame.at(x, y);
+        }
+    }
+    slot_numbers[slot] = number;
+    count++;
+    lock.unlock();
+    ready.notify_one();
+}
+
+void Video_Exporter::encode_loop() {
+    while (true) {
+        unsigned int slot;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this] { return count > 0 || stopping; });
+            if (count == 0) {
+                return;
+            }
+            slot = head;
+        }
+
+        {
+            Timeline_Scope scope("encode");
+            encode(slots[slot], slot_numbers[slot]);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            head = (head + 1) % slots.size();
+            count--;
+        }
+        space.notify_one();
+    }
+}
+
+void Video_Exporter::encode(const std::vector<unsigned char>& frame, unsigned long long number) {
+    // lit pixels are black on white, matching the SFML display; the extra
+    // XO-CHIP colours become grays
+    static const unsigned char GRAYS[4] = {255, 0, 170, 85};
+    int scale = options.scale;
+    int out_width = width * scale;
+    for (int y = 0; y < height * scale; y++) {
+        for (int x = 0; x < out_width; x++) {
+            scaled[y * out_width + x] = GRAYS[frame[(y / scale) * width + x / scale] & 3u];
+        }
+    }
+
+    if (stream != nullptr) {
+        if (options.format == Video_Format::Y4M) {
+            fputs("FRAME\n", stream);
+            fwrite(scaled.data(), 1, scaled.size(), stream);
+            // neutral chroma, the image is grayscale
+            int chroma = ((out_width + 1) / 2) * ((height * scale + 1) / 2) * 2;
+            for (int i = 0; i < chroma; i++) {
+                fputc(128, stream);
+            }
+        } else {
+            fwrite(scaled.data(), 1, scaled.size(), stream);
+        }
+    }
+
+    if (options.png_every != 0 && number % options.png_every == 0) {
+        write_png(options.png_prefix + std::to_string(number) + ".png", scaled.data(), width * options.scale,
+                  height * options.scale);
+    }
+}
+
+static unsigned int crc32(const unsigned char* data, size_t length, unsigned int crc = 0) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+static void put_u32(std::vector<unsigned char>& out, unsigned int value) {
+    out.push_back(value >> 24);
+    out.push_back(value >> 16);
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+static void put_chunk(FILE* file, const char* type, const std::vector<unsigned char>& data) {
+    std::vector<unsigned char> chunk;
+    put_u32(chunk, data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    put_u32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+    fwrite(chunk.data(), 1, chunk.size(), file);
+}
+
+// The zlib stream uses stored (uncompressed) deflate blocks, which keeps
+// this free of dependencies
+bool write_png(const std::string& path, const unsigned char* pixels, int out_width, int out_height) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        fprintf(stderr, "[ERROR] Could not open %s\n", path.c_str());
+        return false;
+    }
+
+    std::vector<unsigned char> raw;
+    for (int y = 0; y < out_height; y++) {
+        // filter type 0 (none) for every row
+        raw.push_back(0);
+        raw.insert(raw.end(), pixels + y * out_width, pixels + (y + 1) * out_width);
+    }
+
+    std::vector<unsigned char> idat = {0x78, 0x01};
+    for (size_t start = 0; start < raw.size(); start += 65535) {
+        size_t length = raw.size() - start < 65535 ? raw.size() - start : 65535;
+        idat.push_back(start + length == raw.size() ? 1 : 0);
+        idat.push_back(length & 0xFF);
+        idat.push_back(length >> 8);
+        idat.push_back(~length & 0xFF);
+        idat.push_back((~length >> 8) & 0xFF);
+        idat.insert(idat.end(), raw.begin() + start, raw.begin() + start + length);
+    }
+    unsigned int a = 1, b = 0;
+    for (unsigned char byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    put_u32(idat, (b << 16) | a);
+
+    std::vector<unsigned char> ihdr;
+    put_u32(ihdr, out_width);
+    put_u32(ihdr, out_height);
+    ihdr.push_back(8); // bit depth
+    ihdr.push_back(0); // grayscale
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+
+    const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(signature, 1, sizeof(signature), file);
+    put_chunk(file, "IHDR", ihdr);
+    put_chunk(file, "IDAT", idat);
+    put_chunk(file, "IEND", {});
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,109 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "Chip8_Headless.h"
+#include "Chip8_Profile.h"
+#include "Chip8_Session.h"
+#include "Chip8_Video.h"
+
+static const char* USAGE =
+    "usage: chip-8-headless <rom> [--frames N] [--print] [--hash] [--realtime] [--profiles PATH]\n"
+    "                       [--variant chip8|schip|xochip] [--quirks modern|cowgod|vip|schip|xochip] [--ipf N]\n"
+    "                       [--timing instructions|vip] [--run-ahead N] [--timeline PATH]\n"
+    "                       [--adaptive [--ipf-min N] [--ipf-max N]] [--stats] [--shm NAME]\n"
+    "                       [--watch | --watch-replay]\n"
+    "                       [--y4m PATH | --raw PATH] [--scale N] [--png-every N] [--png-prefix P]\n";
+
+// Runs a ROM without a window, as fast as the host allows unless --realtime
+// is given. --frames stops after N emulated frames, --print dumps the last
+// frame, --hash prints the ROM's profile hash and exits,
+// --variant/--quirks/--ipf override the ROM's profile, --timing vip charges
+// COSMAC VIP cycle costs, --run-ahead N shows frames N frames early,
+// --timeline writes a Chrome trace of every frame's phases to PATH,
+// --adaptive tunes instructions per frame to how much the ROM idles, --stats
+// prints what the runner did, --shm NAME publishes every frame and takes keys
+// through the shared memory segment NAME (see Chip8_Shared.h),
+// --watch/--watch-replay reload the ROM when its file changes,
+// --y4m/--raw record every frame to PATH ("-" for stdout) and --png-every
+// also writes PNG snapshots. Diagnostics always go to stderr, and --print and
+// --stats too while the video goes to stdout.
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("%s", USAGE);
+        return 2;
+    }
+
+    Session_Options options;
+    options.rom = argv[1];
+    unsigned long long max_frames = 0;
+    bool print = false;
+    bool realtime = false;
+    bool hash = false;
+    Video_Options video;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            max_frames = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--print") == 0) {
+            print = true;
+        } else if (strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        } else if (strcmp(argv[i], "--hash") == 0) {
+            hash = true;
+        } else if (strcmp(argv[i], "--y4m") == 0 && i + 1 < argc) {
+            video.format = Video_Format::Y4M;
+            video.path = argv[++i];
+        } else if (strcmp(argv[i], "--raw") == 0 && i + 1 < argc) {
+            video.format = Video_Format::RAW;
+            video.path = argv[++i];
+        } else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            video.scale = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--png-every") == 0 && i + 1 < argc) {
+            video.png_every = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--png-prefix") == 0 && i + 1 < argc) {
+            video.png_prefix = argv[++i];
+        } else if (!options.parse(argc, argv, i)) {
+            fprintf(stderr, "Unknown option or bad value for %s\n%s", argv[i], USAGE);
+            return 2;
+        }
+    }
+
+    if (hash) {
+        printf("%016llx\n", (unsigned long long)hash_rom(options.rom));
+        return 0;
+    }
+
+    Session session(options);
+    if (!session.start()) {
+        return 1;
+    }
+    Chip8_Machine& chip8 = *session.chip8;
+
+    // timers run on virtual time, so going flat out does not change the game
+    options.run.sync = realtime ? Sync_Mode::WALL_CLOCK : Sync_Mode::UNTHROTTLED;
+    Chip8_Headless headless(chip8.get_frame_view(), max_frames);
+    if (video.format != Video_Format::NONE || video.png_every != 0) {
+        Frame_View frame = chip8.get_frame_view();
+        video.drop_when_full = realtime;
+        Video_Exporter exporter(video, frame.width, frame.height);
+        run_emulator(chip8, headless, {&headless, &exporter}, options.run);
+    } else {
+        run_emulator(chip8, headless, {&headless}, options.run);
+    }
+    // the exporter has joined its encoder thread by now
+    session.finish();
+
+    // stdout may be carrying the video
+    FILE* report = video.format != Video_Format::NONE && video.path == "-" ? stderr : stdout;
+    if (print) {
+        headless.print_frame(report);
+    }
+    if (options.print_stats) {
+        session.stats.print(report);
+    }
+
+#ifdef CHIP8_TRACE
+    chip8.get_trace().close_file();
+#endif
+    return 0;
+}
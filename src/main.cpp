@@ -1,57 +1,77 @@
-#include <SFML/Graphics/RenderWindow.hpp>
-#include <chrono>
-#include <iostream>
-#include "Chip8.h"
+#include <cstdio>
+#include <cstring>
 #include "Chip8_Display.h"
-#include "constants.h"
+#include "Chip8_Session.h"
 
-#include <SFML/Graphics.hpp>
+static const char* USAGE =
+    "usage: chip-8 [rom] [--profiles PATH] [--variant chip8|schip|xochip]\n"
+    "              [--quirks modern|cowgod|vip|schip|xochip] [--ipf N] [--sync wall|audio]\n"
+    "              [--timing instructions|vip] [--run-ahead N] [--latency] [--timeline PATH]\n"
+    "              [--adaptive [--ipf-min N] [--ipf-max N]] [--stats] [--shm NAME]\n"
+    "              [--watch | --watch-replay]\n";
 
-int main()
+// The machine and speed come from the ROM's profile unless overridden.
+// --timing vip runs CHIP-8 at the speed of the original COSMAC VIP and
+// --run-ahead N shows the game N frames early to hide input latency and
+// --latency prints histograms of key press to screen latency on exit.
+// --timeline writes a Chrome trace of every frame's phases to PATH.
+// --adaptive tunes instructions per frame to how much the ROM idles and
+// --stats prints what the runner did on exit.
+// --shm NAME lets other processes watch the screen and press keys through
+// the shared memory segment NAME (see Chip8_Shared.h).
+// --watch reloads the ROM whenever its file is rewritten, keeping the window
+// open, and --watch-replay also replays the session's input on the new ROM
+// to carry on from the same frame.
+// --sync audio lets the sound card's clock pace the emulator.
+int main(int argc, char** argv)
 {
-    Chip8 chip8;
+    // e.g. roms/test_opcode.ch8 or roms/c8_test.c8
+    const char* rom = argc > 1 ? argv[1] : "roms/Space Invaders.ch8";
+    Session_Options options;
+    options.rom = rom;
+    bool measure_latency = false;
 
-    chip8.load_rom_to_memory("roms/Space Invaders.ch8");
-    // chip8.load_rom_to_memory("roms/known_test.ch8");
-    // chip8.load_rom_to_memory("roms/test_opcode.ch8");
-    // chip8.load_rom_to_memory("roms/c8_test.c8");
-
-    auto lastInstructionTime = std::chrono::high_resolution_clock::now();
-    auto lastTimerUpdateTime = std::chrono::high_resolution_clock::now();
-
-    float timer_delay = 1000.0f/TIMER_HZ;
-    float instruction_delay = 1000.0f/INSTRUCTION_HZ;
-
-    Chip8_Display display(chip8, 10);
-    sf::RenderWindow* window = display.get_window();
-    while (window->isOpen()) {
-        sf::Event event;
-        while (window->pollEvent(event))
-        {
-            if (event.type == sf::Event::Closed)
-                window->close();
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--sync") == 0 && i + 1 < argc && strcmp(argv[i + 1], "wall") == 0) {
+            options.run.sync = Sync_Mode::WALL_CLOCK;
+            i++;
+        } else if (strcmp(argv[i], "--sync") == 0 && i + 1 < argc && strcmp(argv[i + 1], "audio") == 0) {
+            options.run.sync = Sync_Mode::AUDIO;
+            i++;
+        } else if (strcmp(argv[i], "--latency") == 0) {
+            measure_latency = true;
+        } else if (!options.parse(argc, argv, i)) {
+            fprintf(stderr, "Unknown option or bad value for %s\n%s", argv[i], USAGE);
+            return 2;
         }
+    }
 
-        if (chip8.draw_flag) {
-            display.render(chip8.frame_buffer);
-            chip8.draw_flag = false;
-        }
-        auto currentTime = std::chrono::high_resolution_clock::now();
-
-        float instructionDifference = std::chrono::duration<float, std::chrono::milliseconds::period>(currentTime - lastInstructionTime).count();
-        float timerUpdateDifference = std::chrono::duration<float, std::chrono::milliseconds::period>(currentTime - lastTimerUpdateTime).count();
-
-        if (instructionDifference > instruction_delay) {
-            lastInstructionTime = currentTime;
-            chip8.complete_one_instruction();
-        }
-        if (timerUpdateDifference > timer_delay) {
-            lastTimerUpdateTime = currentTime;
-            chip8.update_timers();
-        }
+    Session session(options);
+    if (!session.start()) {
+        return 1;
+    }
+    Chip8_Machine& chip8 = *session.chip8;
 
-        // chip8.complete_one_instruction();
-        // chip8.update_timers();
+    // keep the window 640 pixels wide whatever the resolution
+    Frame_View frame = chip8.get_frame_view();
+    Chip8_Display display(frame, 640 / frame.width);
+    Latency_Monitor latency;
+    if (measure_latency) {
+        options.run.latency = &latency;
     }
+    run_emulator(chip8, display, {}, options.run);
+    session.finish();
+    if (options.print_stats) {
+        session.stats.print(stdout);
+    }
+    if (measure_latency) {
+        latency.print(stdout);
+    }
+
+#ifdef CHIP8_TRACE
+    // the instructions leading up to the window being closed
+    chip8.get_trace().dump(stdout, 64);
+    chip8.get_trace().close_file();
+#endif
     return 0;
 }
@@ -0,0 +1,134 @@
+// Checks audio synced mode against a device that plays in real time like
+// SFML's: three chunks in flight, refilled every AUDIO_REFILL_MS. The queue
+// must never grow past the beeper's limit, which bounds how far the speaker
+// trails the sound timer, and rate control must settle rather than sit at
+// either end of its range.
+//
+//   chip8-audio <rom>
+//
+// Exits non-zero if the queue grew past the limit, the device starved or
+// rate control did not settle.
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "Chip8_Factory.h"
+#include "Chip8_Headless.h"
+#include "Chip8_Runner.h"
+
+const int FRAMES = 90;
+// chunks the device may find short; the emulator starts cold
+const int ALLOWED_UNDERRUNS = 3;
+// rate control is judged on the last SETTLED_FRAMES frames, whose mean must
+// stay within SETTLED_PPM of zero
+const int SETTLED_FRAMES = 30;
+const double SETTLED_PPM = AUDIO_RATE_CONTROL * 1e6 / 2;
+
+class Audio_Backend : public Chip8_Headless {
+    public:
+        std::atomic<unsigned int> most_queued{0};
+        std::atomic<unsigned int> underruns{0};
+        const Run_Stats* stats = nullptr;
+        // the rate control of every frame
+        std::vector<double> rates;
+
+    private:
+        Beeper beeper;
+        std::atomic<bool> playing{true};
+        // started last, once everything it touches exists
+        std::thread device;
+
+    public:
+        Audio_Backend(Frame_View frame, unsigned long long max_frames)
+            : Chip8_Headless(frame, max_frames), device(&Audio_Backend::play, this) {}
+
+        ~Audio_Backend() {
+            playing = false;
+            device.join();
+        }
+
+        Beeper* get_beeper() override { return &beeper; }
+
+        void submit_frame(const Frame_View& frame) override {
+            Chip8_Headless::submit_frame(frame);
+            rates.push_back(stats->audio_rate_ppm);
+        }
+
+    private:
+        void play() {
+            typedef std::chrono::steady_clock Clock;
+            short chunk[AUDIO_CHUNK_SAMPLES];
+            // give the emulator a frame's time before expecting samples
+            std::this_thread::sleep_for(std::chrono::milliseconds(1000 / TIMER_HZ));
+            Clock::time_point start = Clock::now();
+            unsigned long long taken = 0;
+            while (playing) {
+                unsigned int queued = beeper.get_queued();
+                if (queued > most_queued) {
+                    most_queued = queued;
+                }
+                // keep three chunks ahead of what has been played
+                double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                unsigned long long due = (unsigned long long)(seconds * beeper.get_sample_rate());
+                while (taken < due + 3 * AUDIO_CHUNK_SAMPLES) {
+                    if (beeper.get_queued() < (unsigned int)AUDIO_CHUNK_SAMPLES) {
+                        underruns++;
+                    }
+                    beeper.read(chunk, AUDIO_CHUNK_SAMPLES);
+                    taken += AUDIO_CHUNK_SAMPLES;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(AUDIO_REFILL_MS));
+            }
+        }
+};
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        printf("usage: chip8-audio <rom>\n");
+        return 2;
+    }
+    std::unique_ptr<Chip8_Machine> chip8 = make_chip8(Chip8_Variant::CHIP_8, Chip8_Quirk_Set::MODERN,
+                                                      Chip8_Timing_Model::INSTRUCTIONS);
+    if (!chip8->load_rom_to_memory(argv[1])) {
+        return 1;
+    }
+
+    Audio_Backend backend(chip8->get_frame_view(), FRAMES);
+    Run_Stats stats;
+    backend.stats = &stats;
+    Run_Options options;
+    options.sync = Sync_Mode::AUDIO;
+    options.stats = &stats;
+    auto start = std::chrono::steady_clock::now();
+    run_emulator(*chip8, backend, {&backend}, options);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    unsigned int limit = backend.get_beeper()->get_buffered_samples();
+    printf("%d frames in %.2f s, at most %u samples queued (limit %u), %u underruns\n", FRAMES, seconds,
+           backend.most_queued.load(), limit, backend.underruns.load());
+    printf("rate control:");
+    for (size_t i = 0; i < backend.rates.size(); i += 10) {
+        printf(" %+.0f", backend.rates[i]);
+    }
+    printf(" ppm\n");
+    double settled = 0;
+    for (size_t i = backend.rates.size() - SETTLED_FRAMES; i < backend.rates.size(); i++) {
+        settled += backend.rates[i] / SETTLED_FRAMES;
+    }
+
+    if (backend.most_queued > limit) {
+        printf("[FAIL] the queue grew past its limit\n");
+        return 1;
+    }
+    if (backend.underruns > (unsigned int)ALLOWED_UNDERRUNS) {
+        printf("[FAIL] the device ran out of samples\n");
+        return 1;
+    }
+    if (settled > SETTLED_PPM || settled < -SETTLED_PPM) {
+        printf("[FAIL] rate control sat at %+.0f ppm over the last %d frames\n", settled, SETTLED_FRAMES);
+        return 1;
+    }
+    printf("[ OK ] audio synced, rate control settled at %+.0f ppm\n", settled);
+    return 0;
+}
@@ -0,0 +1,266 @@
+// Runs the test ROMs listed in tests/conformance.txt, each on its own thread,
+// and compares the frame hash each one ends on with its golden hash. A
+// mismatch prints the golden and actual frames as a diff and, with
+// --diff-dir, also writes it as <name>.png (golden | actual | difference).
+//
+//   chip8-conformance <repo root> [--diff-dir DIR] [--update]
+//
+// --update reruns everything and rewrites the hashes and golden frames
+// instead of checking them. Exits non-zero if any ROM did not match.
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Chip8_Factory.h"
+#include "Chip8_Hash.h"
+#include "Chip8_Video.h"
+
+static const char* USAGE = "usage: chip8-conformance <repo root> [--diff-dir DIR] [--update]\n";
+
+static const char* MANIFEST = "tests/conformance.txt";
+static const char* GOLDEN_DIR = "tests/golden/";
+
+// pixels of the diff PNG per emulated pixel
+const int DIFF_SCALE = 4;
+
+struct Conformance_Case {
+    std::string name;
+    std::string rom;
+    std::string variant_name;
+    std::string quirks_name;
+    Chip8_Variant variant;
+    Chip8_Quirk_Set quirks;
+    unsigned int instructions_per_frame;
+    unsigned int frames;
+    uint64_t golden_hash;
+
+    // filled in by run_case
+    std::string frame;
+    int width = 0;
+    int height = 0;
+    uint64_t hash = 0;
+    bool loaded = false;
+};
+
+static bool load_manifest(const std::string& path, std::vector<Conformance_Case>& cases) {
+    std::ifstream file(path);
+    if (!file) {
+        printf("[ERROR] Could not open %s\n", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        Conformance_Case test;
+        std::string hash;
+        if (!(fields >> test.name >> test.rom >> test.variant_name >> test.quirks_name >>
+              test.instructions_per_frame >> test.frames >> hash) ||
+            !parse_hash(hash.c_str(), test.golden_hash) ||
+            !parse_variant(test.variant_name.c_str(), test.variant) ||
+            !parse_quirk_set(test.quirks_name.c_str(), test.quirks) || test.instructions_per_frame == 0) {
+            printf("[ERROR] %s:%d is not a valid test\n", path.c_str(), line_number);
+            return false;
+        }
+        cases.push_back(test);
+    }
+    return true;
+}
+
+// The frame as chip-8-headless --print shows it, one line per row
+static std::string frame_text(const Frame_View& frame) {
+    std::string text;
+    for (int y = 0; y < frame.height; y++) {
+        for (int x = 0; x < frame.width; x++) {
+            text += ".#+%"[frame.at(x, y) & 3u];
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+static void run_case(const std::string& root, Conformance_Case& test) {
+    std::ifstream file(root + "/" + test.rom, std::ios::binary);
+    if (!file) {
+        return;
+    }
+    std::vector<unsigned char> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::unique_ptr<Chip8_Machine> chip8 = make_chip8(test.variant, test.quirks);
+    chip8->load_rom(rom.data(), rom.size());
+    chip8->set_cycles_per_tick(test.instructions_per_frame);
+    for (unsigned int i = 0; i < test.frames; i++) {
+        chip8->run_frame();
+    }
+
+    Frame_View frame = chip8->get_frame_view();
+    test.frame = frame_text(frame);
+    test.width = frame.width;
+    test.height = frame.height;
+    test.hash = chip8->get_frame_hash();
+    test.loaded = true;
+}
+
+static std::string read_text(const std::string& path) {
+    std::ifstream file(path);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// '+' is lit only in the actual frame, '-' only in the golden one and '*'
+// lit in both in different colours
+static void print_diff(const Conformance_Case& test, const std::string& golden) {
+    printf("    golden %016llx, actual %016llx; + only actual, - only golden, * other colour\n",
+           (unsigned long long)test.golden_hash, (unsigned long long)test.hash);
+    if (golden.size() != test.frame.size()) {
+        printf("    no golden frame of the right size in %s%s.txt, actual frame:\n", GOLDEN_DIR, test.name.c_str());
+        printf("%s", test.frame.c_str());
+        return;
+    }
+    std::string line = "    ";
+    for (size_t i = 0; i < golden.size(); i++) {
+        char want = golden[i];
+        char got = test.frame[i];
+        if (got == '\n') {
+            printf("%s\n", line.c_str());
+            line = "    ";
+        } else if (want == got) {
+            line += got;
+        } else {
+            line += want == '.' ? '+' : got == '.' ? '-' : '*';
+        }
+    }
+}
+
+static void write_diff_png(const std::string& path, const Conformance_Case& test, const std::string& golden) {
+    // golden, actual and difference side by side, one emulated pixel apart
+    static const unsigned char GRAYS[4] = {255, 0, 170, 85};
+    int panel = test.width + 1;
+    int width = (panel * 3 - 1) * DIFF_SCALE;
+    int height = test.height * DIFF_SCALE;
+    std::vector<unsigned char> pixels(width * height, 128);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int column = x / DIFF_SCALE;
+            int offset = column % panel;
+            if (offset == test.width) {
+                continue;
+            }
+            size_t i = (y / DIFF_SCALE) * (test.width + 1) + offset;
+            const char* colours = ".#+%";
+            int want = (int)(strchr(colours, golden[i]) - colours);
+            int got = (int)(strchr(colours, test.frame[i]) - colours);
+            switch (column / panel) {
+                case 0:
+                    pixels[y * width + x] = GRAYS[want];
+                    break;
+                case 1:
+                    pixels[y * width + x] = GRAYS[got];
+                    break;
+                default:
+                    pixels[y * width + x] = want == got ? 255 : 0;
+                    break;
+            }
+        }
+    }
+    write_png(path, pixels.data(), width, height);
+}
+
+static bool write_manifest(const std::string& path, const std::vector<Conformance_Case>& cases) {
+    std::ifstream in(path);
+    std::string line, text;
+    size_t next = 0;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line[0] != '#' && next < cases.size()) {
+            const Conformance_Case& test = cases[next++];
+            char hash[17];
+            snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)test.hash);
+            char formatted[512];
+            snprintf(formatted, sizeof(formatted), "%-20s %-24s %-7s %-7s %-4u %-6u %s", test.name.c_str(),
+                     test.rom.c_str(), test.variant_name.c_str(), test.quirks_name.c_str(),
+                     test.instructions_per_frame, test.frames, hash);
+            line = formatted;
+        }
+        text += line + "\n";
+    }
+    std::ofstream out(path);
+    out << text;
+    return (bool)out;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("%s", USAGE);
+        return 2;
+    }
+    std::string root = argv[1];
+    std::string diff_dir;
+    bool update = false;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--diff-dir") == 0 && i + 1 < argc) {
+            diff_dir = argv[++i];
+        } else if (strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else {
+            printf("%s", USAGE);
+            return 2;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Conformance_Case> cases;
+    if (!load_manifest(root + "/" + MANIFEST, cases)) {
+        return 1;
+    }
+    std::vector<std::thread> threads;
+    for (Conformance_Case& test : cases) {
+        threads.emplace_back(run_case, std::cref(root), std::ref(test));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    int failed = 0;
+    for (const Conformance_Case& test : cases) {
+        if (!test.loaded) {
+            printf("[FAIL] %s: could not open %s\n", test.name.c_str(), test.rom.c_str());
+            failed++;
+            continue;
+        }
+        std::string golden_path = root + "/" + GOLDEN_DIR + test.name + ".txt";
+        if (update) {
+            std::ofstream(golden_path) << test.frame;
+            printf("%-20s %016llx\n", test.name.c_str(), (unsigned long long)test.hash);
+            continue;
+        }
+        if (test.hash == test.golden_hash) {
+            printf("[ OK ] %s\n", test.name.c_str());
+            continue;
+        }
+
+        failed++;
+        printf("[FAIL] %s: %s for %u frames\n", test.name.c_str(), test.rom.c_str(), test.frames);
+        std::string golden = read_text(golden_path);
+        print_diff(test, golden);
+        if (!diff_dir.empty() && golden.size() == test.frame.size()) {
+            write_diff_png(diff_dir + "/" + test.name + ".png", test, golden);
+        }
+    }
+    if (update && !write_manifest(root + "/" + MANIFEST, cases)) {
+        printf("[ERROR] Could not write %s/%s\n", root.c_str(), MANIFEST);
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%zu tests, %d failed, %.3fs\n", cases.size(), failed, seconds);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,307 @@
+// Runs every engine side by side with Reference_Chip8 on random ROMs and on
+// the ROMs given, as CHIP-8 under each of its quirk sets and as SUPER-CHIP
+// and XO-CHIP under their own, comparing state hashes every --every instructions. On a
+// mismatch it goes back to the last matching point, finds the first
+// instruction after which the two differ and prints it with what differs.
+//
+//   chip8-differential [--every N] [--random N] [--instructions N] [rom...]
+//
+// Exits non-zero if any engine diverged.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include "Chip8_Factory.h"
+#include "Chip8_Quirks.h"
+#include "reference_chip8.h"
+
+static const char* USAGE = "usage: chip8-differential [--every N] [--random N] [--instructions N] [rom...]\n";
+
+// An engine under test: builds a machine for a platform and quirk set. New
+// engines are added to ENGINES.
+struct Engine {
+    const char* name;
+    std::unique_ptr<Chip8_Machine> (*make)(Chip8_Variant variant, Chip8_Quirk_Set quirks);
+};
+
+static std::unique_ptr<Chip8_Machine> make_core(Chip8_Variant variant, Chip8_Quirk_Set quirks) {
+    return make_chip8(variant, quirks);
+}
+
+static const Engine ENGINES[] = {
+    {"Chip8_Core", make_core},
+};
+
+struct Test_Options {
+    unsigned int every = 1024;
+    unsigned int random_roms = 500;
+    unsigned long long instructions = 20000;
+};
+
+static unsigned long long instructions_checked = 0;
+
+// Keys held down during the chunk of instructions starting at step, the same
+// on every run so a replay sees them too
+static unsigned short keys_for(unsigned long long step) {
+    uint32_t mix = (uint32_t)(step * 2654435761u) ^ 0x9E3779B9u;
+    mix ^= mix >> 15;
+    // mostly no keys, so FX0A waits as well as returns
+    return (mix & 3) == 0 ? (unsigned short)(mix >> 16) : 0;
+}
+
+static void print_state(const char* name, const Chip8_Cpu_State& state) {
+    printf("    %-10s pc=%03x i=%03x sp=%02x dt=%02x st=%02x key=%02x%s\n               ", name,
+           state.program_counter, state.index_register, state.stack_pointer, state.delay_timer, state.sound_timer,
+           state.key_register, state.halted ? " halted" : "");
+    for (int r = 0; r < 16; r++) {
+        printf(" v%x=%02x", r, state.registers[r]);
+    }
+    printf("\n");
+}
+
+// A platform and quirk set the engines are run as, e.g. "schip"
+struct Case {
+    Chip8_Variant variant;
+    Chip8_Quirk_Set quirks;
+    const char* name;
+};
+
+template <typename Platform, typename Quirks>
+static void report(const char* rom_name, const Engine& engine, const Case& test_case, unsigned long long step,
+                   unsigned short pc, unsigned short opcode, Chip8_Machine& machine,
+                   const Reference_Chip8<Platform, Quirks>& reference) {
+    typedef Reference_Chip8<Platform, Quirks> Reference;
+    printf("[FAIL] %s, %s: %s diverged at instruction %llu, 0x%04x at 0x%03x\n", rom_name, test_case.name,
+           engine.name, step, opcode, pc);
+    print_state(engine.name, machine.get_cpu_state());
+    print_state("reference", reference.get_cpu_state());
+    int shown = 0;
+    for (int address = 0; address < Reference::MEMORY && shown < 8; address++) {
+        if (machine.read_memory(address) != reference.memory[address]) {
+            printf("    memory[%03x] %02x, reference %02x\n", address, machine.read_memory(address),
+                   reference.memory[address]);
+            shown++;
+        }
+    }
+    uint64_t words[Reference::FRAME_WORDS];
+    reference.frame_words(words);
+    Frame_View frame = machine.get_frame_view();
+    shown = 0;
+    for (int w = 0; w < Reference::FRAME_WORDS && shown < 8; w++) {
+        if (frame.rows[w] != words[w]) {
+            int row = w / Reference::WORDS_PER_ROW;
+            printf("    plane %d row %d word %d %016llx, reference %016llx\n", row / Reference::HEIGHT,
+                   row % Reference::HEIGHT, w % Reference::WORDS_PER_ROW, (unsigned long long)frame.rows[w],
+                   (unsigned long long)words[w]);
+            shown++;
+        }
+    }
+}
+
+template <typename Platform, typename Quirks>
+static bool run_case(const Engine& engine, const Case& test_case, const std::vector<unsigned char>& rom,
+                     const char* rom_name, const Test_Options& options) {
+    std::unique_ptr<Chip8_Machine> machine = engine.make(test_case.variant, test_case.quirks);
+    Reference_Chip8<Platform, Quirks> reference;
+    machine->load_rom(rom.data(), rom.size());
+    reference.load_rom(rom.data(), rom.size());
+
+    // the last point where both agreed
+    std::unique_ptr<Chip8_Machine> saved_machine = machine->fork();
+    Reference_Chip8<Platform, Quirks> saved_reference = reference;
+
+    for (unsigned long long step = 0; step < options.instructions; step += options.every) {
+        unsigned short keys = keys_for(step);
+        machine->set_keypad(keys);
+        reference.keypad = keys;
+        machine->run_instructions(options.every);
+        for (unsigned int k = 0; k < options.every; k++) {
+            reference.step();
+        }
+        instructions_checked += options.every;
+
+        if (machine->hash_state() == reference.hash_state()) {
+            // from here on only the timers would change
+            if (reference.halted) {
+                return true;
+            }
+            saved_machine->copy_state_from(*machine);
+            saved_reference = reference;
+            continue;
+        }
+
+        // replay the chunk one instruction at a time
+        machine->copy_state_from(*saved_machine);
+        reference = saved_reference;
+        for (unsigned int k = 0; k < options.every; k++) {
+            unsigned short pc = reference.pc;
+            unsigned short opcode = reference.next_opcode();
+            machine->complete_one_instruction();
+            reference.step();
+            if (machine->hash_state() != reference.hash_state()) {
+                report(rom_name, engine, test_case, step + k, pc, opcode, *machine, reference);
+                return false;
+            }
+        }
+        printf("[FAIL] %s, %s: %s diverged in the chunk at instruction %llu but not on replay\n", rom_name,
+               test_case.name, engine.name, step);
+        return false;
+    }
+    return true;
+}
+
+static bool run_all(const std::vector<unsigned char>& rom, const char* rom_name, const Test_Options& options) {
+    bool passed = true;
+    static const Case MODERN = {Chip8_Variant::CHIP_8, Chip8_Quirk_Set::MODERN, "chip8, modern quirks"};
+    static const Case COWGOD = {Chip8_Variant::CHIP_8, Chip8_Quirk_Set::COWGOD, "chip8, cowgod quirks"};
+    static const Case VIP = {Chip8_Variant::CHIP_8, Chip8_Quirk_Set::VIP, "chip8, vip quirks"};
+    static const Case SCHIP = {Chip8_Variant::SUPER_CHIP, Chip8_Quirk_Set::SUPER_CHIP, "schip"};
+    static const Case XOCHIP = {Chip8_Variant::XO_CHIP, Chip8_Quirk_Set::XO_CHIP, "xochip"};
+    for (const Engine& engine : ENGINES) {
+        passed &= run_case<Chip8_Platform, Modern_Quirks>(engine, MODERN, rom, rom_name, options);
+        passed &= run_case<Chip8_Platform, Cowgod_Quirks>(engine, COWGOD, rom, rom_name, options);
+        passed &= run_case<Chip8_Platform, Vip_Quirks>(engine, VIP, rom, rom_name, options);
+        passed &= run_case<Super_Chip_Platform, Super_Chip_Quirks>(engine, SCHIP, rom, rom_name, options);
+        passed &= run_case<Xo_Chip_Platform, Xo_Chip_Quirks>(engine, XOCHIP, rom, rom_name, options);
+    }
+    return passed;
+}
+
+// A ROM of valid CHIP-8, SUPER-CHIP and XO-CHIP instructions with random
+// operands; a platform without an extension skips its instructions as
+// invalid, and so does the reference. Jumps and calls stay inside the ROM
+// and I mostly points at memory the ROM can safely scribble on, so runs last
+// rather than falling into zeroed memory. 00FD is left out, as it would end
+// the run.
+static std::vector<unsigned char> random_rom(uint32_t& seed) {
+    auto next = [&seed]() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    };
+    static const unsigned short SYSTEM_OPS[] = {0x00E0, 0x00C0, 0x00D0, 0x00FB, 0x00FC, 0x00FE, 0x00FF};
+    static const unsigned short ALU_OPS[] = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE};
+    static const unsigned short COMPARE_OPS[] = {0x0, 0x2, 0x3};
+    // F000 and F002 only exist with X = 0
+    static const unsigned short F_OPS[] = {0x07, 0x0A, 0x15, 0x18, 0x1E, 0x29, 0x33, 0x55,
+                                           0x65, 0x30, 0x75, 0x85, 0x3A, 0x01, 0x02, 0x00};
+    const int INSTRUCTIONS = 256;
+
+    std::vector<unsigned char> rom;
+    for (int k = 0; k < INSTRUCTIONS; k++) {
+        uint32_t r = next();
+        unsigned short x = (r >> 4) & 0xF;
+        unsigned short y = (r >> 8) & 0xF;
+        unsigned short target = 0x200 + ((r >> 12) % INSTRUCTIONS) * 2;
+        unsigned short op;
+        switch (r & 0xF) {
+            case 0x0:
+                // returns are rarer than calls, or most runs would end early
+                // on an empty stack
+                op = (r >> 16) % 4 == 0 ? 0x00EE : SYSTEM_OPS[(r >> 18) % 7];
+                // scrolls down and up by N
+                if ((op & 0xFFE0) == 0x00C0) {
+                    op |= (r >> 24) & 0xF;
+                }
+                break;
+            case 0x1:
+            case 0x2:
+                op = (r & 0xF) << 12 | target;
+                break;
+            case 0x5:
+                op = 0x5000 | x << 8 | y << 4 | COMPARE_OPS[(r >> 16) % 3];
+                break;
+            case 0x8:
+                op = 0x8000 | x << 8 | y << 4 | ALU_OPS[(r >> 16) % 9];
+                break;
+            case 0xA:
+                // above the ROM, or anywhere now and then
+                op = 0xA000 | ((r >> 16) % 8 == 0 ? (r >> 20) & 0xFFF : 0x600 + ((r >> 20) & 0x7FF));
+                break;
+            case 0xB:
+                op = 0xB000 | (target & 0xF00) | ((r >> 16) & 0x0F);
+                break;
+            case 0xD: {
+                // 16x16 and tall sprites as often as short ones
+                unsigned short n = (r >> 16) % 4 == 0 ? 0 : (r >> 16) % 4 == 1 ? 8 + ((r >> 18) & 7) : (r >> 18) & 0xF;
+                op = 0xD000 | x << 8 | y << 4 | n;
+                break;
+            }
+            case 0xE:
+                op = 0xE000 | x << 8 | ((r >> 16) & 1 ? 0x9E : 0xA1);
+                break;
+            case 0xF:
+                op = F_OPS[(r >> 16) & 0xF];
+                op = 0xF000 | (op == 0x00 || op == 0x02 ? 0 : x << 8) | op;
+                // F000 takes the word after it as a 16 bit I, beyond the
+                // first 4 KB
+                if (op == 0xF000 && k + 1 < INSTRUCTIONS) {
+                    unsigned short address = 0x1000 + next() % 0xF000;
+                    rom.push_back(op >> 8);
+                    rom.push_back(op & 0xFF);
+                    op = address;
+                    k++;
+                }
+                break;
+            default:
+                op = (r & 0xF) << 12 | x << 8 | ((r >> 16) & 0xFF);
+                break;
+        }
+        rom.push_back(op >> 8);
+        rom.push_back(op & 0xFF);
+    }
+    return rom;
+}
+
+int main(int argc, char** argv) {
+    Test_Options options;
+    std::vector<const char*> roms;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--every") == 0 && i + 1 < argc) {
+            options.every = (unsigned int)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--random") == 0 && i + 1 < argc) {
+            options.random_roms = (unsigned int)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--instructions") == 0 && i + 1 < argc) {
+            options.instructions = strtoull(argv[++i], nullptr, 10);
+        } else if (argv[i][0] == '-') {
+            printf("%s", USAGE);
+            return 2;
+        } else {
+            roms.push_back(argv[i]);
+        }
+    }
+    if (options.every == 0) {
+        printf("%s", USAGE);
+        return 2;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool passed = true;
+    for (const char* path : roms) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            printf("[ERROR] Could not open rom %s\n", path);
+            passed = false;
+            continue;
+        }
+        std::vector<unsigned char> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        passed &= run_all(rom, path, options);
+    }
+
+    uint32_t seed = RANDOM_SEED;
+    char name[32];
+    for (unsigned int k = 0; k < options.random_roms; k++) {
+        snprintf(name, sizeof(name), "random rom %u", k);
+        passed &= run_all(random_rom(seed), name, options);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%s: %llu instructions compared in %.2fs (%.1fM per second)\n", passed ? "passed" : "FAILED",
+           instructions_checked, seconds, instructions_checked / seconds / 1e6);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,497 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "constants.h"
+#include "Chip8_Hash.h"
+#include "Chip8_Machine.h"
+#include "Chip8_Platform.h"
+
+// Deliberately plain CHIP-8 interpreter to test the real cores against. It
+// shares nothing with Chip8_Core but the platform and quirk flags: flat
+// memory, one bool per pixel, every opcode decoded in the most obvious way.
+// Whatever it does that Chip8_Core also defines (bounded stack, wrapping
+// addresses, the random generator, one step per instruction, low resolution
+// pixels covering LORES_SCALE x LORES_SCALE frame pixels) it does the same
+// way, so the two hash equal after every step.
+template <typename Platform, typename Quirks>
+struct Reference_Chip8 {
+    static constexpr int WIDTH = Platform::FRAME_WIDTH;
+    static constexpr int HEIGHT = Platform::FRAME_HEIGHT;
+    static constexpr int WORDS_PER_ROW = WIDTH / 64;
+    static constexpr int PLANES = Platform::PLANES;
+    static constexpr int MEMORY = Platform::MEMORY_BYTES;
+
+    unsigned char memory[MEMORY] = {0};
+    unsigned char v[16] = {0};
+    unsigned short i = 0;
+    unsigned short pc = 0x200;
+    // return addresses, high byte first, as Chip8_Core keeps them
+    unsigned char stack[STACK_BYTES] = {0};
+    unsigned char sp = 0;
+    unsigned char delay_timer = 0;
+    unsigned char sound_timer = 0;
+    unsigned char key_register = 0xFF;
+    bool halted = false;
+    bool pixels[PLANES][HEIGHT][WIDTH] = {};
+    // SUPER-CHIP
+    bool hires = false;
+    unsigned char rpl_flags[RPL_FLAGS] = {0};
+    // XO-CHIP
+    unsigned char plane_mask = 1;
+    unsigned char audio_pattern[AUDIO_PATTERN_BYTES] = {0};
+    bool has_audio_pattern = false;
+    unsigned char pitch = DEFAULT_AUDIO_PITCH;
+    uint32_t random_state = RANDOM_SEED;
+    unsigned short keypad = 0;
+    unsigned long long steps = 0;
+    unsigned int steps_per_tick = DEFAULT_INSTRUCTIONS_PER_FRAME;
+
+    Reference_Chip8() {
+        memcpy(memory, PRESET_DIGIT_SPRITES, PRESET_DIGIT_SPRITES_SIZE);
+        if (Platform::SUPER_CHIP) {
+            memcpy(memory + BIG_DIGIT_SPRITES_START, PRESET_BIG_DIGIT_SPRITES, PRESET_BIG_DIGIT_SPRITES_SIZE);
+        }
+    }
+
+    void load_rom(const unsigned char* bytes, size_t size) {
+        for (size_t k = 0; k < size && 0x200 + k < (size_t)MEMORY; k++) {
+            memory[0x200 + k] = bytes[k];
+        }
+    }
+
+    void step() {
+        if (!halted && key_register != 0xFF) {
+            for (int key = 0; key < 16; key++) {
+                if (keypad & (1 << key)) {
+                    v[key_register] = key;
+                    key_register = 0xFF;
+                    break;
+                }
+            }
+        }
+        if (!halted && key_register == 0xFF) {
+            execute();
+        }
+        steps++;
+        if (steps % steps_per_tick == 0) {
+            if (delay_timer > 0) {
+                delay_timer--;
+            }
+            if (sound_timer > 0) {
+                sound_timer--;
+            }
+        }
+    }
+
+    // the instruction the next step runs
+    unsigned short next_opcode() const {
+        return memory[pc % MEMORY] << 8 | memory[(pc + 1) % MEMORY];
+    }
+
+    // XO-CHIP skips the whole 4 byte F000 NNNN
+    void skip() {
+        if (Platform::XO_CHIP && next_opcode() == 0xF000) {
+            pc += 2;
+        }
+        pc += 2;
+    }
+
+    void execute() {
+        unsigned short op = next_opcode();
+        pc += 2;
+        int x = (op >> 8) & 0xF;
+        int y = (op >> 4) & 0xF;
+        int n = op & 0xF;
+        int nn = op & 0xFF;
+        int nnn = op & 0xFFF;
+        int result;
+
+        switch (op >> 12) {
+            case 0x0:
+                if (op == 0x00E0) {
+                    for (int p = 0; p < PLANES; p++) {
+                        if (plane_mask >> p & 1) {
+                            memset(pixels[p], 0, sizeof(pixels[p]));
+                        }
+                    }
+                } else if (op == 0x00EE) {
+                    if (sp < 2) {
+                        halted = true;
+                    } else {
+                        sp -= 2;
+                        pc = stack[sp] << 8 | stack[sp + 1];
+                    }
+                } else if (Platform::SUPER_CHIP && (op & 0xFFF0) == 0x00C0) {
+                    scroll(0, n * scroll_scale());
+                } else if (Platform::XO_CHIP && (op & 0xFFF0) == 0x00D0) {
+                    scroll(0, -n * scroll_scale());
+                } else if (Platform::SUPER_CHIP && op == 0x00FB) {
+                    scroll(4 * scroll_scale(), 0);
+                } else if (Platform::SUPER_CHIP && op == 0x00FC) {
+                    scroll(-4 * scroll_scale(), 0);
+                } else if (Platform::SUPER_CHIP && op == 0x00FD) {
+                    halted = true;
+                } else if (Platform::SUPER_CHIP && (op == 0x00FE || op == 0x00FF)) {
+                    hires = op == 0x00FF;
+                    if (Platform::XO_CHIP) {
+                        memset(pixels, 0, sizeof(pixels));
+                    }
+                }
+                break;
+            case 0x1:
+                pc = nnn;
+                break;
+            case 0x2:
+                if (sp + 2 > STACK_BYTES) {
+                    halted = true;
+                } else {
+                    stack[sp] = pc >> 8;
+                    stack[sp + 1] = pc & 0xFF;
+                    sp += 2;
+                }
+                pc = nnn;
+                break;
+            case 0x3:
+                if (v[x] == nn) {
+                    skip();
+                }
+                break;
+            case 0x4:
+                if (v[x] != nn) {
+                    skip();
+                }
+                break;
+            case 0x5:
+                if (Platform::XO_CHIP && n == 0x2) {
+                    for (int k = 0; k <= abs(x - y); k++) {
+                        memory[(i + k) % MEMORY] = v[x < y ? x + k : x - k];
+                    }
+                } else if (Platform::XO_CHIP && n == 0x3) {
+                    for (int k = 0; k <= abs(x - y); k++) {
+                        v[x < y ? x + k : x - k] = memory[(i + k) % MEMORY];
+                    }
+                } else if (v[x] == v[y]) {
+                    skip();
+                }
+                break;
+            case 0x6:
+                v[x] = nn;
+                break;
+            case 0x7:
+                v[x] = v[x] + nn;
+                break;
+            case 0x8:
+                switch (n) {
+                    case 0x0:
+                        v[x] = v[y];
+                        break;
+                    case 0x1:
+                        v[x] = v[x] | v[y];
+                        if (Quirks::LOGIC_RESETS_VF) {
+                            v[0xF] = 0;
+                        }
+                        break;
+                    case 0x2:
+                        v[x] = v[x] & v[y];
+                        if (Quirks::LOGIC_RESETS_VF) {
+                            v[0xF] = 0;
+                        }
+                        break;
+                    case 0x3:
+                        v[x] = v[x] ^ v[y];
+                        if (Quirks::LOGIC_RESETS_VF) {
+                            v[0xF] = 0;
+                        }
+                        break;
+                    case 0x4:
+                        result = v[x] + v[y];
+                        v[x] = result & 0xFF;
+                        v[0xF] = result > 0xFF;
+                        break;
+                    case 0x5:
+                        result = v[x] - v[y];
+                        v[x] = result & 0xFF;
+                        v[0xF] = result >= 0;
+                        break;
+                    case 0x6:
+                        result = Quirks::SHIFT_USES_VY ? v[y] : v[x];
+                        v[x] = result >> 1;
+                        v[0xF] = result & 1;
+                        break;
+                    case 0x7:
+                        result = v[y] - v[x];
+                        v[x] = result & 0xFF;
+                        v[0xF] = result >= 0;
+                        break;
+                    case 0xE:
+                        result = Quirks::SHIFT_USES_VY ? v[y] : v[x];
+                        v[x] = (result << 1) & 0xFF;
+                        v[0xF] = result >> 7;
+                        break;
+                }
+                break;
+            case 0x9:
+                if (v[x] != v[y]) {
+                    skip();
+                }
+                break;
+            case 0xA:
+                i = nnn;
+                break;
+            case 0xB:
+                pc = nnn + (Quirks::JUMP_USES_VX ? v[x] : v[0]);
+                break;
+            case 0xC:
+                random_state ^= random_state << 13;
+                random_state ^= random_state >> 17;
+                random_state ^= random_state << 5;
+                v[x] = (random_state >> 24) & nn;
+                break;
+            case 0xD:
+                draw(v[x], v[y], n);
+                break;
+            case 0xE:
+                if (nn == 0x9E && (keypad >> (v[x] & 0xF) & 1)) {
+                    skip();
+                } else if (nn == 0xA1 && !(keypad >> (v[x] & 0xF) & 1)) {
+                    skip();
+                }
+                break;
+            case 0xF:
+                switch (nn) {
+                    case 0x00:
+                        if (Platform::XO_CHIP && x == 0) {
+                            i = memory[pc % MEMORY] << 8 | memory[(pc + 1) % MEMORY];
+                            pc += 2;
+                        }
+                        break;
+                    case 0x01:
+                        if (Platform::XO_CHIP) {
+                            plane_mask = x & 0x3;
+                        }
+                        break;
+                    case 0x02:
+                        if (Platform::XO_CHIP && x == 0) {
+                            for (int k = 0; k < AUDIO_PATTERN_BYTES; k++) {
+                                audio_pattern[k] = memory[(i + k) % MEMORY];
+                            }
+                            has_audio_pattern = true;
+                        }
+                        break;
+                    case 0x07:
+                        v[x] = delay_timer;
+                        break;
+                    case 0x0A:
+                        key_register = x;
+                        break;
+                    case 0x15:
+                        delay_timer = v[x];
+                        break;
+                    case 0x18:
+                        sound_timer = v[x];
+                        break;
+                    case 0x1E:
+                        i = i + v[x];
+                        break;
+                    case 0x29:
+                        i = (v[x] & 0xF) * 5;
+                        break;
+                    case 0x30:
+                        if (Platform::SUPER_CHIP) {
+                            i = BIG_DIGIT_SPRITES_START + (v[x] & 0xF) * 10;
+                        }
+                        break;
+                    case 0x3A:
+                        if (Platform::XO_CHIP) {
+                            pitch = v[x];
+                        }
+                        break;
+                    case 0x33:
+                        memory[i % MEMORY] = v[x] / 100;
+                        memory[(i + 1) % MEMORY] = v[x] / 10 % 10;
+                        memory[(i + 2) % MEMORY] = v[x] % 10;
+                        break;
+                    case 0x55:
+                        for (int k = 0; k <= x; k++) {
+                            memory[(i + k) % MEMORY] = v[k];
+                        }
+                        if (Quirks::LOAD_STORE_INCREMENTS_I) {
+                            i += x + 1;
+                        }
+                        break;
+                    case 0x65:
+                        for (int k = 0; k <= x; k++) {
+                            v[k] = memory[(i + k) % MEMORY];
+                        }
+                        if (Quirks::LOAD_STORE_INCREMENTS_I) {
+                            i += x + 1;
+                        }
+                        break;
+                    case 0x75:
+                        if (Platform::SUPER_CHIP) {
+                            for (int k = 0; k <= x && k < RPL_FLAGS; k++) {
+                                rpl_flags[k] = v[k];
+                            }
+                        }
+                        break;
+                    case 0x85:
+                        if (Platform::SUPER_CHIP) {
+                            for (int k = 0; k <= x && k < RPL_FLAGS; k++) {
+                                v[k] = rpl_flags[k];
+                            }
+                        }
+                        break;
+                }
+                break;
+        }
+    }
+
+    // XO-CHIP scrolls by low resolution pixels in low resolution mode
+    int scroll_scale() const {
+        return Platform::XO_CHIP && !hires ? Platform::LORES_SCALE : 1;
+    }
+
+    // moves the selected planes right by dx and down by dy frame pixels,
+    // left and up for negative ones, clearing what moves in
+    void scroll(int dx, int dy) {
+        for (int p = 0; p < PLANES; p++) {
+            if (!(plane_mask >> p & 1)) {
+                continue;
+            }
+            bool old[HEIGHT][WIDTH];
+            memcpy(old, pixels[p], sizeof(old));
+            for (int y = 0; y < HEIGHT; y++) {
+                for (int x = 0; x < WIDTH; x++) {
+                    int from_x = x - dx;
+                    int from_y = y - dy;
+                    bool inside = from_x >= 0 && from_x < WIDTH && from_y >= 0 && from_y < HEIGHT;
+                    pixels[p][y][x] = inside && old[from_y][from_x];
+                }
+            }
+        }
+    }
+
+    void draw(int vx, int vy, int n) {
+        int scale = hires ? 1 : Platform::LORES_SCALE;
+        int width = WIDTH / scale;
+        int height = HEIGHT / scale;
+        // SUPER-CHIP DXY0 is 16x16, two bytes per row
+        bool wide = Platform::SUPER_CHIP && n == 0;
+        int rows = wide ? 16 : n;
+        int columns = wide ? 16 : 8;
+        int x0 = vx % width;
+        int y0 = vy % height;
+
+        v[0xF] = 0;
+        unsigned int address = i;
+        for (int p = 0; p < PLANES; p++) {
+            if (!(plane_mask >> p & 1)) {
+                continue;
+            }
+            for (int r = 0; r < rows; r++) {
+                int y = y0 + r;
+                if (y >= height) {
+                    if (Quirks::CLIP_SPRITES) {
+                        break;
+                    }
+                    y %= height;
+                }
+                for (int c = 0; c < columns; c++) {
+                    int x = x0 + c;
+                    if (x >= width) {
+                        if (Quirks::CLIP_SPRITES) {
+                            break;
+                        }
+                        x %= width;
+                    }
+                    unsigned char bits = memory[(address + (wide ? r * 2 + c / 8 : r)) % MEMORY];
+                    if (!(bits & (0x80 >> c % 8))) {
+                        continue;
+                    }
+                    // every frame pixel the sprite pixel covers
+                    for (int sy = 0; sy < scale; sy++) {
+                        for (int sx = 0; sx < scale; sx++) {
+                            bool& pixel = pixels[p][y * scale + sy][x * scale + sx];
+                            if (pixel) {
+                                v[0xF] = 1;
+                            }
+                            pixel = !pixel;
+                        }
+                    }
+                }
+            }
+            address += wide ? 32 : rows;
+        }
+    }
+
+    Chip8_Cpu_State get_cpu_state() const {
+        Chip8_Cpu_State state;
+        memcpy(state.registers, v, sizeof(v));
+        state.index_register = i;
+        state.program_counter = pc;
+        state.stack_pointer = sp;
+        state.delay_timer = delay_timer;
+        state.sound_timer = sound_timer;
+        state.key_register = key_register;
+        state.halted = halted;
+        return state;
+    }
+
+    // the frame buffer as Chip8_Core stores it: plane after plane,
+    // WORDS_PER_ROW words per row, leftmost pixel in the top bit
+    static constexpr int FRAME_WORDS = PLANES * HEIGHT * WORDS_PER_ROW;
+    void frame_words(uint64_t* words) const {
+        memset(words, 0, FRAME_WORDS * sizeof(uint64_t));
+        for (int p = 0; p < PLANES; p++) {
+            for (int y = 0; y < HEIGHT; y++) {
+                for (int x = 0; x < WIDTH; x++) {
+                    words[(p * HEIGHT + y) * WORDS_PER_ROW + x / 64] |= (uint64_t)pixels[p][y][x] << (63 - x % 64);
+                }
+            }
+        }
+    }
+
+    // Chip8_Machine::get_frame_hash worked out from scratch
+    uint64_t frame_hash_of() const {
+        uint64_t words[FRAME_WORDS];
+        frame_words(words);
+        uint64_t hash = 0;
+        for (int w = 0; w < FRAME_WORDS; w++) {
+            hash ^= element_hash(w, words[w]);
+        }
+        return hash;
+    }
+
+    // same fields in the same order as Chip8_Core::hash_state
+    uint64_t hash_state() const {
+        uint64_t hash = fnv1a(v, sizeof(v));
+        hash = fnv1a(&i, sizeof(i), hash);
+        hash = fnv1a(&pc, sizeof(pc), hash);
+        hash = fnv1a(&sp, sizeof(sp), hash);
+        hash = fnv1a(&delay_timer, sizeof(delay_timer), hash);
+        hash = fnv1a(&sound_timer, sizeof(sound_timer), hash);
+        hash = fnv1a(&key_register, sizeof(key_register), hash);
+        hash = fnv1a(&halted, sizeof(halted), hash);
+        hash = fnv1a(&random_state, sizeof(random_state), hash);
+        hash = fnv1a(stack, sp, hash);
+        uint64_t memory_hash = 0;
+        for (int address = 0; address < MEMORY; address++) {
+            memory_hash ^= element_hash(address, memory[address]);
+        }
+        hash = fnv1a(&memory_hash, sizeof(memory_hash), hash);
+        uint64_t frame_hash = frame_hash_of();
+        hash = fnv1a(&frame_hash, sizeof(frame_hash), hash);
+        if (Platform::SUPER_CHIP) {
+            hash = fnv1a(&hires, sizeof(hires), hash);
+            hash = fnv1a(rpl_flags, sizeof(rpl_flags), hash);
+        }
+        if (Platform::XO_CHIP) {
+            hash = fnv1a(&plane_mask, sizeof(plane_mask), hash);
+            hash = fnv1a(audio_pattern, sizeof(audio_pattern), hash);
+            hash = fnv1a(&has_audio_pattern, sizeof(has_audio_pattern), hash);
+            hash = fnv1a(&pitch, sizeof(pitch), hash);
+        }
+        return hash;
+    }
+};
@@ -0,0 +1,91 @@
+// Checks that --watch-replay resumes where the machine was: runs a ROM for a
+// while on changing keys and cycles per tick, rewrites the ROM file with the
+// same bytes and compares the reloaded machine with the live one, under
+// both timing models, replaying from the start and from a checkpoint.
+//
+//   chip8-reload <rom>
+//
+// Exits non-zero if a reloaded machine differs from the live one.
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "Chip8_Factory.h"
+#include "Chip8_Reload.h"
+
+// written in the working directory, which the reloader then watches
+static const char* ROM_COPY = "reload_test.ch8";
+const int FRAMES = 600;
+// often enough that the last reload replays from a checkpoint
+const unsigned int CHECKPOINT_FRAMES = 250;
+
+static bool write_rom(const std::vector<unsigned char>& rom) {
+    std::ofstream file(ROM_COPY, std::ios::binary);
+    file.write((const char*)rom.data(), rom.size());
+    return (bool)file;
+}
+
+static bool run_case(const std::vector<unsigned char>& rom, Chip8_Timing_Model timing, unsigned int checkpoint_frames,
+                     const char* name) {
+    if (!write_rom(rom)) {
+        printf("[ERROR] Could not write %s\n", ROM_COPY);
+        return false;
+    }
+    std::unique_ptr<Chip8_Machine> chip8 = make_chip8(Chip8_Variant::CHIP_8, Chip8_Quirk_Set::MODERN, timing);
+    unsigned int cycles_per_tick = chip8->get_cycles_per_tick();
+    auto make_machine = [timing, cycles_per_tick]() {
+        std::unique_ptr<Chip8_Machine> machine = make_chip8(Chip8_Variant::CHIP_8, Chip8_Quirk_Set::MODERN, timing);
+        machine->set_cycles_per_tick(cycles_per_tick);
+        return machine;
+    };
+    Rom_Reloader reloader(ROM_COPY, make_machine, true, checkpoint_frames);
+    if (!chip8->load_rom_to_memory(ROM_COPY)) {
+        return false;
+    }
+
+    for (int frame = 0; frame < FRAMES; frame++) {
+        // hold each key for a while, and change the speed now and then as
+        // adaptive mode would
+        chip8->set_keypad(frame % 40 < 20 ? 1 << (frame / 40 % 16) : 0);
+        if (frame % 150 == 75) {
+            chip8->set_cycles_per_tick(chip8->get_cycles_per_tick() + (frame % 300 == 75 ? 3 : -2));
+        }
+        reloader.record_frame(*chip8);
+        chip8->run_frame();
+    }
+
+    uint64_t live_hash = chip8->hash_state();
+    unsigned long long live_cycles = chip8->get_cycles();
+    if (!write_rom(rom) || !reloader.reload_if_changed(*chip8)) {
+        printf("[FAIL] %s: the rewritten ROM was not reloaded\n", name);
+        return false;
+    }
+    if (chip8->hash_state() != live_hash || chip8->get_cycles() != live_cycles) {
+        printf("[FAIL] %s: live %016llx after %llu cycles, replayed %016llx after %llu cycles\n", name,
+               (unsigned long long)live_hash, live_cycles, (unsigned long long)chip8->hash_state(),
+               chip8->get_cycles());
+        return false;
+    }
+    printf("[ OK ] %s\n", name);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        printf("usage: chip8-reload <rom>\n");
+        return 2;
+    }
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file) {
+        printf("[ERROR] Could not open rom %s\n", argv[1]);
+        return 1;
+    }
+    std::vector<unsigned char> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    bool passed = run_case(rom, Chip8_Timing_Model::INSTRUCTIONS, FRAMES, "instruction timing");
+    passed &= run_case(rom, Chip8_Timing_Model::VIP, FRAMES, "VIP timing");
+    passed &= run_case(rom, Chip8_Timing_Model::INSTRUCTIONS, CHECKPOINT_FRAMES, "instruction timing, checkpoints");
+    passed &= run_case(rom, Chip8_Timing_Model::VIP, CHECKPOINT_FRAMES, "VIP timing, checkpoints");
+    remove(ROM_COPY);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+// Checks that run-ahead leaves nothing speculative in a trace file: runs a
+// ROM on changing keys with and without run-ahead, tracing to a file each
+// time, and compares the two files. Needs a core built with CHIP8_TRACE.
+//
+//   chip8-trace-test <rom>
+//
+// Exits non-zero if the traces differ.
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "Chip8_Factory.h"
+#include "Chip8_Headless.h"
+#include "Chip8_Runner.h"
+
+// written in the working directory
+static const char* PLAIN_TRACE = "trace_test.plain.c8trace";
+static const char* AHEAD_TRACE = "trace_test.ahead.c8trace";
+const int FRAMES = 300;
+// enough instructions per frame for run-ahead frames to cross buffer flushes
+const unsigned int CYCLES_PER_TICK = 1000;
+
+// changes the keys Space Invaders moves and fires with on every frame, so
+// the frames run ahead see other input than the real ones that follow
+class Scripted_Backend : public Chip8_Headless {
+    private:
+        unsigned int polls = 0;
+
+    public:
+        using Chip8_Headless::Chip8_Headless;
+
+        unsigned short poll_input() override {
+            unsigned int poll = polls++;
+            return poll % 3 == 0 ? 0 : 1 << (4 + poll % 3);
+        }
+};
+
+static std::vector<char> read_file(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+static bool run_traced(const char* rom, const char* trace, unsigned int run_ahead) {
+    std::unique_ptr<Chip8_Machine> chip8 = make_chip8(Chip8_Variant::CHIP_8, Chip8_Quirk_Set::MODERN,
+                                                      Chip8_Timing_Model::INSTRUCTIONS);
+    chip8->set_cycles_per_tick(CYCLES_PER_TICK);
+    if (!chip8->load_rom_to_memory(rom)) {
+        return false;
+    }
+    chip8->get_trace().open_file(trace);
+
+    Scripted_Backend backend(chip8->get_frame_view(), FRAMES);
+    Run_Options options;
+    options.sync = Sync_Mode::UNTHROTTLED;
+    options.run_ahead = run_ahead;
+    run_emulator(*chip8, backend, {&backend}, options);
+    chip8->get_trace().close_file();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        printf("usage: chip8-trace-test <rom>\n");
+        return 2;
+    }
+
+    if (!run_traced(argv[1], PLAIN_TRACE, 0) || !run_traced(argv[1], AHEAD_TRACE, 2)) {
+        return 1;
+    }
+    std::vector<char> plain = read_file(PLAIN_TRACE);
+    std::vector<char> ahead = read_file(AHEAD_TRACE);
+    remove(PLAIN_TRACE);
+    remove(AHEAD_TRACE);
+
+    unsigned long long records = plain.size() < sizeof(Trace_File_Header)
+                                     ? 0
+                                     : (plain.size() - sizeof(Trace_File_Header)) / sizeof(Trace_Record);
+    if (records == 0) {
+        printf("[FAIL] nothing was traced\n");
+        return 1;
+    }
+    if (plain != ahead) {
+        size_t offset = 0;
+        while (offset < plain.size() && offset < ahead.size() && plain[offset] == ahead[offset]) {
+            offset++;
+        }
+        printf("[FAIL] the traces differ from record %llu on\n",
+               (unsigned long long)((offset - sizeof(Trace_File_Header)) / sizeof(Trace_Record)));
+        return 1;
+    }
+    printf("[ OK ] %llu records with and without run-ahead\n", records);
+    return 0;
+}
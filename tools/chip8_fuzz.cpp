@@ -0,0 +1,35 @@
+// libFuzzer target for the instruction core. Needs clang:
+//
+//   cmake -S . -B fuzz -DCHIP8_FUZZ=ON -DCMAKE_CXX_COMPILER=clang++
+//   cmake --build fuzz --target chip8-fuzz
+//   ./fuzz/chip8-fuzz -close_fd_mask=2 corpus roms
+//
+// The input is loaded as a ROM. Its first byte also picks the platform, quirk
+// set and timing model, so any ROM is a usable seed. The next two bytes are
+// held down as the keypad, so key waits and skips take both branches. Each
+// run can still print its first invalid instruction and the fault that halts
+// it to stderr; -close_fd_mask=2 drops those, while libFuzzer and the
+// sanitizers keep reporting.
+#include "Chip8_Factory.h"
+#include <cstddef>
+#include <cstdint>
+
+// enough to get well past a ROM's setup code while keeping runs short
+const unsigned int FUZZ_INSTRUCTIONS = 4096;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    unsigned char selector = size > 0 ? data[0] : 0;
+    Chip8_Variant variant = (Chip8_Variant)(selector % 3);
+    Chip8_Quirk_Set quirks = (Chip8_Quirk_Set)(selector / 3 % 5);
+    Chip8_Timing_Model timing = variant == Chip8_Variant::CHIP_8 && selector / 15 % 2
+                                    ? Chip8_Timing_Model::VIP
+                                    : Chip8_Timing_Model::INSTRUCTIONS;
+
+    std::unique_ptr<Chip8_Machine> chip8 = make_chip8(variant, quirks, timing);
+    chip8->load_rom(data, size);
+    chip8->set_keypad(size > 2 ? (unsigned short)(data[1] | data[2] << 8) : 0);
+    for (unsigned int i = 0; i < FUZZ_INSTRUCTIONS && !chip8->is_halted(); i++) {
+        chip8->complete_one_instruction();
+    }
+    return 0;
+}
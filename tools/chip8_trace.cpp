@@ -0,0 +1,235 @@
+// Offline viewer for binary execution traces written by CHIP8_TRACE builds.
+//
+//   chip8-trace info <trace>
+//   chip8-trace show <trace> [--pc LO-HI] [--opcode VALUE[/MASK]] [--from N] [--count N]
+//   chip8-trace diff <trace_a> <trace_b> [--context N]
+//
+// Traces are memory mapped, so they can be much larger than RAM.
+#include "Chip8_Trace.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct Trace_File {
+    const Trace_Record* records = nullptr;
+    unsigned long long count = 0;
+
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+};
+
+static bool open_trace(const char* path, Trace_File& trace) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("[ERROR] Could not open %s\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Trace_File_Header)) {
+        printf("[ERROR] %s is not a trace file\n", path);
+        close(fd);
+        return false;
+    }
+
+    trace.mapping_size = st.st_size;
+    trace.mapping = mmap(nullptr, trace.mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (trace.mapping == MAP_FAILED) {
+        printf("[ERROR] Could not map %s\n", path);
+        return false;
+    }
+    madvise(trace.mapping, trace.mapping_size, MADV_SEQUENTIAL);
+
+    const Trace_File_Header* header = (const Trace_File_Header*)trace.mapping;
+    if (memcmp(header->magic, TRACE_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != TRACE_FILE_VERSION || header->record_size != sizeof(Trace_Record)) {
+        printf("[ERROR] %s has an unsupported trace format\n", path);
+        munmap(trace.mapping, trace.mapping_size);
+        return false;
+    }
+
+    trace.records = (const Trace_Record*)((const char*)trace.mapping + sizeof(Trace_File_Header));
+    trace.count = (trace.mapping_size - sizeof(Trace_File_Header)) / sizeof(Trace_Record);
+    return true;
+}
+
+static void close_trace(Trace_File& trace) {
+    if (trace.mapping != nullptr) {
+        munmap(trace.mapping, trace.mapping_size);
+    }
+}
+
+static void print_record(unsigned long long index, const Trace_Record& r) {
+    printf("%12llu  0x%03x: 0x%04x I=0x%03x", index, r.program_counter, r.instruction, r.index_register);
+    for (int k = 0; k < 16; k++) {
+        if (r.changed_registers & (1u << k)) {
+            printf(" V%x=0x%02x", k, r.registers[k]);
+        }
+    }
+    printf("\n");
+}
+
+static int usage() {
+    printf("usage: chip8-trace info <trace>\n");
+    printf("       chip8-trace show <trace> [--pc LO-HI] [--opcode VALUE[/MASK]] [--from N] [--count N]\n");
+    printf("       chip8-trace diff <trace_a> <trace_b> [--context N]\n");
+    return 2;
+}
+
+static int info(const Trace_File& trace) {
+    unsigned long long group_counts[16] = {0};
+    for (unsigned long long i = 0; i < trace.count; i++) {
+        group_counts[trace.records[i].instruction >> 12]++;
+    }
+    printf("%llu instructions\n", trace.count);
+    for (int i = 0; i < 16; i++) {
+        printf("  %xNNN: %llu\n", i, group_counts[i]);
+    }
+    return 0;
+}
+
+static int show(const Trace_File& trace, int argc, char** argv) {
+    unsigned int pc_low = 0, pc_high = 0xFFFF;
+    unsigned int opcode_value = 0, opcode_mask = 0;
+    unsigned long long from = 0, count = ~0ull;
+
+    for (int i = 0; i < argc; i++) {
+        if (i + 1 >= argc) {
+            return usage();
+        }
+        const char* value = argv[i + 1];
+        if (strcmp(argv[i], "--pc") == 0) {
+            if (sscanf(value, "%x-%x", &pc_low, &pc_high) != 2) {
+                return usage();
+            }
+        } else if (strcmp(argv[i], "--opcode") == 0) {
+            opcode_mask = 0xFFFF;
+            if (sscanf(value, "%x/%x", &opcode_value, &opcode_mask) < 1) {
+                return usage();
+            }
+        } else if (strcmp(argv[i], "--from") == 0) {
+            from = strtoull(value, nullptr, 10);
+        } else if (strcmp(argv[i], "--count") == 0) {
+            count = strtoull(value, nullptr, 10);
+        } else {
+            return usage();
+        }
+        i++;
+    }
+
+    unsigned long long shown = 0;
+    for (unsigned long long i = from; i < trace.count && shown < count; i++) {
+        const Trace_Record& r = trace.records[i];
+        if (r.program_counter < pc_low || r.program_counter > pc_high) {
+            continue;
+        }
+        if ((r.instruction & opcode_mask) != (opcode_value & opcode_mask)) {
+            continue;
+        }
+        print_record(i, r);
+        shown++;
+    }
+    return 0;
+}
+
+static int diff(const Trace_File& a, const Trace_File& b, int argc, char** argv) {
+    unsigned long long context = 8;
+    for (int i = 0; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--context") == 0) {
+            context = strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            return usage();
+        }
+    }
+
+    // compare in large blocks first and only walk records inside the block
+    // that differs
+    const unsigned long long BLOCK = 4096;
+    unsigned long long common = a.count < b.count ? a.count : b.count;
+    unsigned long long first = common;
+    for (unsigned long long start = 0; start < common; start += BLOCK) {
+        unsigned long long n = common - start < BLOCK ? common - start : BLOCK;
+        if (memcmp(&a.records[start], &b.records[start], n * sizeof(Trace_Record)) == 0) {
+            continue;
+        }
+        for (unsigned long long i = start; i < start + n; i++) {
+            if (memcmp(&a.records[i], &b.records[i], sizeof(Trace_Record)) != 0) {
+                first = i;
+                break;
+            }
+        }
+        break;
+    }
+
+    if (first == common && a.count == b.count) {
+        printf("Traces are identical (%llu instructions)\n", common);
+        return 0;
+    }
+    if (first == common) {
+        printf("Traces agree for %llu instructions, then %s ends\n", common, a.count < b.count ? "a" : "b");
+        return 1;
+    }
+
+    printf("First divergence at instruction %llu\n", first);
+    unsigned long long begin = first > context ? first - context : 0;
+    for (unsigned long long i = begin; i < first; i++) {
+        print_record(i, a.records[i]);
+    }
+    printf("a:\n");
+    print_record(first, a.records[first]);
+    printf("b:\n");
+    print_record(first, b.records[first]);
+
+    const Trace_Record& ra = a.records[first];
+    const Trace_Record& rb = b.records[first];
+    if (ra.program_counter != rb.program_counter) {
+        printf("  PC differs: 0x%03x vs 0x%03x\n", ra.program_counter, rb.program_counter);
+    }
+    if (ra.instruction != rb.instruction) {
+        printf("  opcode differs: 0x%04x vs 0x%04x\n", ra.instruction, rb.instruction);
+    }
+    if (ra.index_register != rb.index_register) {
+        printf("  I differs: 0x%03x vs 0x%03x\n", ra.index_register, rb.index_register);
+    }
+    for (int k = 0; k < 16; k++) {
+        if (ra.registers[k] != rb.registers[k]) {
+            printf("  V%x differs: 0x%02x vs 0x%02x\n", k, ra.registers[k], rb.registers[k]);
+        }
+    }
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        return usage();
+    }
+
+    Trace_File a;
+    if (!open_trace(argv[2], a)) {
+        return 2;
+    }
+
+    int result;
+    if (strcmp(argv[1], "info") == 0) {
+        result = info(a);
+    } else if (strcmp(argv[1], "show") == 0) {
+        result = show(a, argc - 3, argv + 3);
+    } else if (strcmp(argv[1], "diff") == 0 && argc >= 4) {
+        Trace_File b;
+        if (!open_trace(argv[3], b)) {
+            close_trace(a);
+            return 2;
+        }
+        result = diff(a, b, argc - 4, argv + 4);
+        close_trace(b);
+    } else {
+        result = usage();
+    }
+
+    close_trace(a);
+    return result;
+}